@@ -24,6 +24,7 @@
 #include "include/sdcard.h"
 #include "include/printf.h"
 #include "include/disk.h"
+#include "include/cpustat.h"
 
 struct {
   struct spinlock lock;
@@ -103,8 +104,11 @@ bread(uint dev, uint sectorno) {
 
   b = bget(dev, sectorno);
   if (!b->valid) {
+    CPUSTAT_INC(bmiss);
     disk_read(b);
     b->valid = 1;
+  } else {
+    CPUSTAT_INC(bhit);
   }
 
   return b;
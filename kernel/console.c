@@ -19,7 +19,7 @@
 #include "include/memlayout.h"
 #include "include/riscv.h"
 #include "include/proc.h"
-#include "include/sbi.h"
+#include "include/uart.h"
 
 #define BACKSPACE 0x100
 #define C(x)  ((x)-'@')  // Control-x
@@ -27,13 +27,14 @@
 void consputc(int c) {
   if(c == BACKSPACE){
     // if the user typed backspace, overwrite with a space.
-    sbi_console_putchar('\b');
-    sbi_console_putchar(' ');
-    sbi_console_putchar('\b');
+    uartputc_sync('\b');
+    uartputc_sync(' ');
+    uartputc_sync('\b');
   } else {
-    sbi_console_putchar(c);
+    uartputc_sync(c);
   }
 }
+
 struct {
   struct spinlock lock;
   
@@ -51,16 +52,17 @@ struct {
 int
 consolewrite(int user_src, uint64 src, int n)
 {
-  int i;
-
-  acquire(&cons.lock);
-  for(i = 0; i < n; i++){
-    char c;
-    if(either_copyin(&c, user_src, src+i, 1) == -1)
+  int i, m;
+  char buf[128];
+
+  for(i = 0; i < n; i += m){
+    m = n - i;
+    if(m > sizeof(buf))
+      m = sizeof(buf);
+    if(either_copyin(buf, user_src, src+i, m) == -1)
       break;
-    sbi_console_putchar(c);
+    uartwrite(buf, m);
   }
-  release(&cons.lock);
 
   return i;
 }
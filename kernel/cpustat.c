@@ -0,0 +1,39 @@
+// Per-hart event counters.
+
+#include "include/types.h"
+#include "include/param.h"
+#include "include/riscv.h"
+#include "include/cpustat.h"
+#include "include/string.h"
+#include "include/vm.h"
+
+struct cpustat cpustats[NCPU];
+
+// Copy out to user address addr hart cpu's counters, or their
+// sum over all harts if cpu is -1, a few at a time so as not to
+// put a whole struct cpustat on the kernel stack. Counters may
+// move while we read; each is read once, so every value is one
+// that really was.
+int
+cpustat_copyout(int cpu, uint64 addr)
+{
+  uint64 buf[16], *src;
+  int i, j, c, m, n = sizeof(struct cpustat) / sizeof(uint64);
+
+  if(cpu < -1 || cpu >= NCPU)
+    return -1;
+  for(i = 0; i < n; i += m){
+    m = n - i < NELEM(buf) ? n - i : NELEM(buf);
+    memset(buf, 0, sizeof(buf));
+    for(c = 0; c < NCPU; c++){
+      if(cpu != -1 && c != cpu)
+        continue;
+      src = (uint64 *)&cpustats[c] + i;
+      for(j = 0; j < m; j++)
+        buf[j] += *(volatile uint64 *)&src[j];
+    }
+    if(copyout2(addr + i * sizeof(uint64), (char *)buf, m * sizeof(uint64)) < 0)
+      return -1;
+  }
+  return 0;
+}
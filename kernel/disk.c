@@ -4,6 +4,8 @@
 #include "include/riscv.h"
 
 #include "include/buf.h"
+#include "include/cpustat.h"
+#include "include/latency.h"
 
 #ifndef QEMU
 #include "include/sdcard.h"
@@ -23,20 +25,28 @@ void disk_init(void)
 
 void disk_read(struct buf *b)
 {
+    uint64 t0 = lat_begin();
+
+    CPUSTAT_INC(diskread);
     #ifdef QEMU
 	virtio_disk_rw(b, 0);
     #else 
 	sdcard_read_sector(b->data, b->sectorno);
 	#endif
+    lat_end(LAT_DISKREAD, t0);
 }
 
 void disk_write(struct buf *b)
 {
+    uint64 t0 = lat_begin();
+
+    CPUSTAT_INC(diskwrite);
     #ifdef QEMU
 	virtio_disk_rw(b, 1);
     #else 
 	sdcard_write_sector(b->data, b->sectorno);
 	#endif
+    lat_end(LAT_DISKWRITE, t0);
 }
 
 void disk_intr(void)
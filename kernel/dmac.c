@@ -26,6 +26,8 @@
 
 volatile dmac_t *const dmac = (dmac_t *)DMAC_V;
 
+static struct spinlock dmac_lock;
+
 static int is_memory(uintptr_t address)
 {
     enum
@@ -261,6 +263,7 @@ void dmac_init(void)
     dmac_cfg_u_t dmac_cfg;
     dmac_reset_u_t dmac_reset;
 
+    initlock(&dmac_lock, "dmac");
     sysctl_clock_enable(SYSCTL_CLOCK_DMA);
     // printf("[dmac_init] dma clk=%d\n", sysctl_clock_get_freq(SYSCTL_CLOCK_DMA));
 
@@ -340,15 +343,19 @@ static void *dmac_chan = (void *) DMAC_V;
 
 void dmac_wait_idle(dmac_channel_number_t channel_num)
 {
+    // dmac_lock orders the idle check against dmac_intr(),
+    // so the wakeup can't slip in before we are asleep.
+    acquire(&dmac_lock);
     while(!dmac_is_idle(channel_num)) {
-        acquire(&myproc()->lock);
-        sleep(dmac_chan, &myproc()->lock);
-        release(&myproc()->lock);
+        sleep(dmac_chan, &dmac_lock);
     }
+    release(&dmac_lock);
 }
 
 void dmac_intr(dmac_channel_number_t channel_num)
 {
+    acquire(&dmac_lock);
     dmac_chanel_interrupt_clear(channel_num);
     wakeup(dmac_chan);
+    release(&dmac_lock);
 }
\ No newline at end of file
@@ -53,6 +53,12 @@ int exec(char *path, char **argv)
   pagetable_t kpagetable = 0, oldkpagetable;
   struct proc *p = myproc();
 
+  // Other threads of p's group would be left running
+  // in the address space that exec is about to free.
+  if (p->group != p || p->nthreads > 0) {
+    return -1;
+  }
+
   // Make a copy of p->kpt without old user space, 
   // but with the same kstack we are using now, which can't be changed
   if ((kpagetable = (pagetable_t)kalloc()) == NULL) {
@@ -69,7 +75,9 @@ int exec(char *path, char **argv)
     #endif
     goto bad;
   }
-  elock(ep);
+  // exec only reads the file, so several execs of one program
+  // can load it at once.
+  elockshared(ep);
 
   // Check ELF header
   if(eread(ep, 0, (uint64) &elf, 0, sizeof(elf)) != sizeof(elf))
@@ -98,7 +106,7 @@ int exec(char *path, char **argv)
     if(loadseg(pagetable, ph.vaddr, ep, ph.off, ph.filesz) < 0)
       goto bad;
   }
-  eunlock(ep);
+  eunlockshared(ep);
   eput(ep);
   ep = 0;
 
@@ -172,7 +180,7 @@ int exec(char *path, char **argv)
   if(kpagetable)
     kvmfree(kpagetable, 0);
   if(ep){
-    eunlock(ep);
+    eunlockshared(ep);
     eput(ep);
   }
   return -1;
@@ -9,6 +9,7 @@
 #include "include/fat32.h"
 #include "include/string.h"
 #include "include/printf.h"
+#include "include/cpustat.h"
 
 /* fields that start with "_" are something we don't use */
 
@@ -111,7 +112,8 @@ int fat32_init()
         panic("byts_per_sec != BSIZE");
     initlock(&ecache.lock, "ecache");
     memset(&root, 0, sizeof(root));
-    initsleeplock(&root.lock, "entry");
+    initrwsleeplock(&root.lock, "entry");
+    initlock(&root.curlock, "entry cursor");
     root.attribute = (ATTR_DIRECTORY | ATTR_SYSTEM);
     root.first_clus = root.cur_clus = fat.bpb.root_clus;
     root.valid = 1;
@@ -125,7 +127,8 @@ int fat32_init()
         de->parent = 0;
         de->next = root.next;
         de->prev = &root;
-        initsleeplock(&de->lock, "entry");
+        initrwsleeplock(&de->lock, "entry");
+        initlock(&de->curlock, "entry cursor");
         root.next->prev = de;
         root.next = de;
     }
@@ -270,46 +273,62 @@ static uint rw_clus(uint32 cluster, int write, int user, uint64 data, uint off,
 }
 
 /**
- * for the given entry, relocate the cur_clus field based on the off
- * @param   entry       modify its cur_clus field
+ * for the given entry, move a cluster cursor to the cluster holding off
+ * @param   entry       the file whose FAT chain to follow
+ * @param   cur         the cursor's cluster, updated
+ * @param   cnt         the cursor's cluster index in the chain, updated
  * @param   off         the offset from the beginning of the relative file
  * @param   alloc       whether alloc new cluster when meeting end of FAT chains
- * @return              the offset from the new cur_clus
+ * @return              the offset from the new *cur
  */
-static int reloc_clus(struct dirent *entry, uint off, int alloc)
+static int seek_clus(struct dirent *entry, uint32 *cur, uint *cnt, uint off, int alloc)
 {
     int clus_num = off / fat.byts_per_clus;
-    while (clus_num > entry->clus_cnt) {
-        int clus = read_fat(entry->cur_clus);
+    while (clus_num > *cnt) {
+        int clus = read_fat(*cur);
         if (clus >= FAT32_EOC) {
             if (alloc) {
                 clus = alloc_clus(entry->dev);
-                write_fat(entry->cur_clus, clus);
+                write_fat(*cur, clus);
             } else {
-                entry->cur_clus = entry->first_clus;
-                entry->clus_cnt = 0;
+                *cur = entry->first_clus;
+                *cnt = 0;
                 return -1;
             }
         }
-        entry->cur_clus = clus;
-        entry->clus_cnt++;
+        *cur = clus;
+        (*cnt)++;
     }
-    if (clus_num < entry->clus_cnt) {
-        entry->cur_clus = entry->first_clus;
-        entry->clus_cnt = 0;
-        while (entry->clus_cnt < clus_num) {
-            entry->cur_clus = read_fat(entry->cur_clus);
-            if (entry->cur_clus >= FAT32_EOC) {
+    if (clus_num < *cnt) {
+        *cur = entry->first_clus;
+        *cnt = 0;
+        while (*cnt < clus_num) {
+            *cur = read_fat(*cur);
+            if (*cur >= FAT32_EOC) {
                 panic("reloc_clus");
             }
-            entry->clus_cnt++;
+            (*cnt)++;
         }
     }
     return off % fat.byts_per_clus;
 }
 
+/**
+ * for the given entry, relocate the cur_clus field based on the off
+ * @param   entry       modify its cur_clus field
+ * @param   off         the offset from the beginning of the relative file
+ * @param   alloc       whether alloc new cluster when meeting end of FAT chains
+ * @return              the offset from the new cur_clus
+ */
+static int reloc_clus(struct dirent *entry, uint off, int alloc)
+{
+    return seek_clus(entry, &entry->cur_clus, &entry->clus_cnt, off, alloc);
+}
+
 /* like the original readi, but "reade" is odd, let alone "writee" */
-// Caller must hold entry->lock.
+// Caller must hold entry->lock, shared or exclusive. Readers
+// sharing the lock walk a private copy of the cluster cursor,
+// and put it back under curlock for the next read to start from.
 int eread(struct dirent *entry, int user_dst, uint64 dst, uint off, uint n)
 {
     if (off > entry->file_size || off + n < off || (entry->attribute & ATTR_DIRECTORY)) {
@@ -319,17 +338,26 @@ int eread(struct dirent *entry, int user_dst, uint64 dst, uint off, uint n)
         n = entry->file_size - off;
     }
 
-    uint tot, m;
-    for (tot = 0; entry->cur_clus < FAT32_EOC && tot < n; tot += m, off += m, dst += m) {
-        reloc_clus(entry, off, 0);
+    uint tot, m, cnt;
+    uint32 cur;
+    acquire(&entry->curlock);
+    cur = entry->cur_clus;
+    cnt = entry->clus_cnt;
+    release(&entry->curlock);
+    for (tot = 0; cur < FAT32_EOC && tot < n; tot += m, off += m, dst += m) {
+        seek_clus(entry, &cur, &cnt, off, 0);
         m = fat.byts_per_clus - off % fat.byts_per_clus;
         if (n - tot < m) {
             m = n - tot;
         }
-        if (rw_clus(entry->cur_clus, 0, user_dst, dst, off % fat.byts_per_clus, m) != m) {
+        if (rw_clus(cur, 0, user_dst, dst, off % fat.byts_per_clus, m) != m) {
             break;
         }
     }
+    acquire(&entry->curlock);
+    entry->cur_clus = cur;
+    entry->clus_cnt = cnt;
+    release(&entry->curlock);
     return tot;
 }
 
@@ -382,10 +410,12 @@ static struct dirent *eget(struct dirent *parent, char *name)
                     ep->parent->ref++;
                 }
                 release(&ecache.lock);
+                CPUSTAT_INC(ehit);
                 // edup(ep->parent);
                 return ep;
             }
         }
+        CPUSTAT_INC(emiss);
     }
     for (ep = root.prev; ep != &root; ep = ep->prev) {              // LRU algo
         if (ep->ref == 0) {
@@ -653,14 +683,31 @@ void elock(struct dirent *entry)
 {
     if (entry == 0 || entry->ref < 1)
         panic("elock");
-    acquiresleep(&entry->lock);
+    acquirewrite(&entry->lock);
 }
 
 void eunlock(struct dirent *entry)
 {
-    if (entry == 0 || !holdingsleep(&entry->lock) || entry->ref < 1)
+    if (entry == 0 || !holdingwrite(&entry->lock) || entry->ref < 1)
         panic("eunlock");
-    releasesleep(&entry->lock);
+    releasewrite(&entry->lock);
+}
+
+// Shared lock, for eread() only: others may read alongside.
+void elockshared(struct dirent *entry)
+{
+    if (entry == 0 || entry->ref < 1)
+        panic("elockshared");
+    acquireread(&entry->lock);
+}
+
+void eunlockshared(struct dirent *entry)
+{
+    // releaseread() panics if nobody holds it to read; which
+    // process does is not recorded.
+    if (entry == 0 || entry->ref < 1)
+        panic("eunlockshared");
+    releaseread(&entry->lock);
 }
 
 void eput(struct dirent *entry)
@@ -668,8 +715,8 @@ void eput(struct dirent *entry)
     acquire(&ecache.lock);
     if (entry != &root && entry->valid != 0 && entry->ref == 1) {
         // ref == 1 means no other process can have entry locked,
-        // so this acquiresleep() won't block (or deadlock).
-        acquiresleep(&entry->lock);
+        // so this acquirewrite() won't block (or deadlock).
+        acquirewrite(&entry->lock);
         entry->next->prev = entry->prev;
         entry->prev->next = entry->next;
         entry->next = root.next;
@@ -684,7 +731,7 @@ void eput(struct dirent *entry)
             eupdate(entry);
             eunlock(entry->parent);
         }
-        releasesleep(&entry->lock);
+        releasewrite(&entry->lock);
 
         // Once entry->ref decreases down to 0, we can't guarantee the entry->parent field remains unchanged.
         // Because eget() may take the entry away and write it.
@@ -892,7 +939,7 @@ static struct dirent *lookup_path(char *path, int parent, char *name)
     if (*path == '/') {
         entry = edup(&root);
     } else if (*path != '\0') {
-        entry = edup(myproc()->cwd);
+        entry = edup(myproc()->group->cwd);
     } else {
         return NULL;
     }
@@ -16,6 +16,7 @@
 #include "include/printf.h"
 #include "include/string.h"
 #include "include/vm.h"
+#include "include/fcntl.h"
 
 struct devsw devsw[NDEV];
 struct {
@@ -125,7 +126,7 @@ fileread(struct file *f, uint64 addr, int n)
 
   switch (f->type) {
     case FD_PIPE:
-        r = piperead(f->pipe, addr, n);
+        r = piperead(f->pipe, 1, addr, n);
         break;
     case FD_DEVICE:
         if(f->major < 0 || f->major >= NDEV || !devsw[f->major].read)
@@ -133,10 +134,20 @@ fileread(struct file *f, uint64 addr, int n)
         r = devsw[f->major].read(1, addr, n);
         break;
     case FD_ENTRY:
-        elock(f->ep);
+        // Reads through different opens of a file may share the
+        // entry lock, but f->off needs it exclusive when this
+        // struct file is shared by a fork or between threads.
+        if(f->ref == 1 && myproc()->group->nthreads == 0){
+          elockshared(f->ep);
           if((r = eread(f->ep, 1, addr, f->off, n)) > 0)
             f->off += r;
-        eunlock(f->ep);
+          eunlockshared(f->ep);
+        } else {
+          elock(f->ep);
+          if((r = eread(f->ep, 1, addr, f->off, n)) > 0)
+            f->off += r;
+          eunlock(f->ep);
+        }
         break;
     default:
       panic("fileread");
@@ -156,7 +167,7 @@ filewrite(struct file *f, uint64 addr, int n)
     return -1;
 
   if(f->type == FD_PIPE){
-    ret = pipewrite(f->pipe, addr, n);
+    ret = pipewrite(f->pipe, 1, addr, n);
   } else if(f->type == FD_DEVICE){
     if(f->major < 0 || f->major >= NDEV || !devsw[f->major].write)
       return -1;
@@ -177,6 +188,34 @@ filewrite(struct file *f, uint64 addr, int n)
   return ret;
 }
 
+// Set the offset of file f, as lseek(); only regular files
+// can seek, and not past their end.
+// Returns the new offset, or -1.
+int
+fileseek(struct file *f, int off, int whence)
+{
+  long pos;
+
+  if(f->type != FD_ENTRY || (f->ep->attribute & ATTR_DIRECTORY))
+    return -1;
+  elock(f->ep);
+  if(whence == SEEK_SET)
+    pos = off;
+  else if(whence == SEEK_CUR)
+    pos = (long)f->off + off;
+  else if(whence == SEEK_END)
+    pos = (long)f->ep->file_size + off;
+  else
+    pos = -1;
+  if(pos < 0 || pos > f->ep->file_size){
+    eunlock(f->ep);
+    return -1;
+  }
+  f->off = pos;
+  eunlock(f->ep);
+  return pos;
+}
+
 // Read from dir f.
 // addr is a user virtual address.
 int
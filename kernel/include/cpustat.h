@@ -0,0 +1,38 @@
+#ifndef __CPUSTAT_H
+#define __CPUSTAT_H
+
+#include "types.h"
+
+#define CPUSTAT_NSYSCALL  64
+#define CPUSTAT_NIRQ      64
+
+// Event counters, one set per hart, as returned by cpustat().
+// Each hart only ever adds to its own set; readers sum them.
+struct cpustat {
+  uint64 ctxsw;       // switches from the scheduler into a process
+  uint64 syscall;     // system calls
+  uint64 pgfault;     // page faults from user mode
+  uint64 intr;        // device interrupts
+  uint64 timer;       // timer interrupts
+  uint64 diskread;    // sectors read from disk
+  uint64 diskwrite;   // sectors written to disk
+  uint64 bhit;        // bread() served from the buffer cache
+  uint64 bmiss;       // bread() that had to go to disk
+  uint64 ehit;        // directory lookups found in the entry cache
+  uint64 emiss;       // directory lookups that missed it
+  uint64 nsyscall[CPUSTAT_NSYSCALL];  // system calls by number
+  uint64 nirq[CPUSTAT_NIRQ];          // device interrupts by IRQ
+} __attribute__((aligned(64)));
+
+// In the kernel: count an event on this hart. The add is atomic
+// so that neither an interrupt nor a move to the other hart in
+// the middle of it can lose a count, yet it needs no lock and the
+// line it touches is almost always this hart's own.
+extern struct cpustat cpustats[];
+#define CPUSTAT_ADD(field, n) \
+  __sync_fetch_and_add(&cpustats[r_tp()].field, (n))
+#define CPUSTAT_INC(field)    CPUSTAT_ADD(field, 1)
+
+int             cpustat_copyout(int cpu, uint64 addr);
+
+#endif
@@ -47,7 +47,8 @@ struct dirent {
     struct dirent *parent;  // because FAT32 doesn't have such thing like inum, use this for cache trick
     struct dirent *next;
     struct dirent *prev;
-    struct sleeplock    lock;
+    struct rwsleeplock  lock;
+    struct spinlock     curlock;    // guards cur_clus/clus_cnt between shared readers
 };
 
 int             fat32_init(void);
@@ -63,6 +64,8 @@ void            eput(struct dirent *entry);
 void            estat(struct dirent *ep, struct stat *st);
 void            elock(struct dirent *entry);
 void            eunlock(struct dirent *entry);
+void            elockshared(struct dirent *entry);
+void            eunlockshared(struct dirent *entry);
 int             enext(struct dirent *dp, struct dirent *ep, uint off, int *count);
 struct dirent*  ename(char *path);
 struct dirent*  enameparent(char *path, char *name);
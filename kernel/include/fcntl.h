@@ -4,3 +4,12 @@
 #define O_APPEND  0x004
 #define O_CREATE  0x200
 #define O_TRUNC   0x400
+
+// lseek() whence
+#define SEEK_SET  0
+#define SEEK_CUR  1
+#define SEEK_END  2
+
+// fcntl() commands
+#define F_SETPIPE_SZ  1031  // resize a pipe's buffer to at least arg bytes
+#define F_GETPIPE_SZ  1032  // get the size of a pipe's buffer
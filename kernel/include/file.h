@@ -33,6 +33,7 @@ void            fileinit(void);
 int             fileread(struct file*, uint64, int n);
 int             filestat(struct file*, uint64 addr);
 int             filewrite(struct file*, uint64, int n);
+int             fileseek(struct file*, int off, int whence);
 int             dirnext(struct file *f, uint64 addr);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,8 @@
+#ifndef __FUTEX_H
+#define __FUTEX_H
+
+// operations for futex()
+#define FUTEX_WAIT      0   // sleep if *addr == val
+#define FUTEX_WAKE      1   // wake up to val waiters on addr
+
+#endif
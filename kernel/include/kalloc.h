@@ -6,6 +6,8 @@
 void*           kalloc(void);
 void            kfree(void *);
 void            kinit(void);
+void            kinithart(void);
+void            kinitwait(void);
 uint64          freemem_amount(void);
 
 #endif
\ No newline at end of file
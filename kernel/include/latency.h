@@ -0,0 +1,43 @@
+#ifndef __LATENCY_H
+#define __LATENCY_H
+
+#include "types.h"
+
+// latency() operations
+#define LAT_GET       0     // copy histogram id to buf; returns NLAT
+#define LAT_START     1     // clear every histogram and start timing
+#define LAT_STOP      2     // stop timing
+
+// What is timed; the histograms are numbered:
+#define LAT_DISKREAD  0     // disk_read(), queueing included
+#define LAT_DISKWRITE 1     // disk_write()
+#define LAT_RUNQ      2     // from RUNNABLE to RUNNING
+#define LAT_INTR      3     // devintr()
+#define LAT_SYSCALL   4     // every system call
+#define LAT_NSYSCALL  64
+#define LAT_SYS(num)  (LAT_SYSCALL + 1 + (num))   // system call num
+#define NLAT          LAT_SYS(LAT_NSYSCALL)
+
+// Bucket b counts times of [2^b, 2^(b+1)) r_time() units,
+// bucket 0 also those of 0, and the last bucket all longer ones.
+#define LAT_NBUCKET   40
+
+struct lathist {
+  uint64 count;
+  uint64 sum;               // r_time() units
+  uint64 max;
+  uint64 bucket[LAT_NBUCKET];
+};
+
+// In the kernel:
+//   uint64 t0 = lat_begin();  ...  lat_end(LAT_..., t0);
+// r_time() traps to SBI on k210, so nothing is timed, and
+// t0 is 0, unless latency(LAT_START) turned timing on.
+extern volatile int lat_on;
+#define lat_begin()   (lat_on ? r_time() : 0)
+
+void            lat_add(int id, uint64 t);
+void            lat_end(int id, uint64 t0);
+int             lat_ctl(int op, int id, uint64 addr);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __LOCKSTAT_H
+#define __LOCKSTAT_H
+
+#include "types.h"
+
+#define LOCKSTAT_NAME 16
+
+// Contention counters for a class of spinlocks, as returned by
+// lockstat(). All locks initialized with the same name share a
+// class, e.g. every per-process "proc" lock.
+// The times are in r_time() units and only kept by kernels
+// built with LOCKSTAT defined; they read 0 otherwise.
+struct lockstat {
+  char name[LOCKSTAT_NAME];
+  uint64 nlocks;      // locks in this class now
+  uint64 nacquire;    // acquisitions
+  uint64 ncontended;  // acquisitions that found the lock held
+  uint64 nspin;       // spin loop iterations spent waiting
+  uint64 spintime;    // time spent waiting
+  uint64 maxhold;     // longest time held
+};
+
+#endif
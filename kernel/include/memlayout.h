@@ -124,6 +124,10 @@
 //   TRAMPOLINE (the same page as in the kernel)
 #define TRAPFRAME               (TRAMPOLINE - PGSIZE)
 
+// Threads share their group's page table, so each maps its
+// own trapframe further down, indexed by its slot in proc[].
+#define TTRAPFRAME(i)           (TRAPFRAME - ((i) + 1) * PGSIZE)
+
 #define MAXUVA                  RUSTSBI_BASE
 
 #endif
@@ -3,6 +3,7 @@
 
 #define NPROC        50  // maximum number of processes
 #define NCPU          2  // maximum number of CPUs
+#define NSLEEPQ      32  // wait-channel hash buckets for sleep()/wakeup()
 #define NOFILE       16  // open files per process
 #define NFILE       100  // open files per system
 #define NINODE       50  // maximum number of active i-nodes
@@ -14,6 +15,11 @@
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
 #define FSSIZE       1000  // size of file system in blocks
 #define MAXPATH      260   // maximum file path name
-#define INTERVAL     (390000000 / 200) // timer interrupt interval
+#ifdef QEMU
+#define CLK_FREQ     10000000          // timebase frequency of r_time()
+#else
+#define CLK_FREQ     390000000
+#endif
+#define INTERVAL     (CLK_FREQ / 200)  // scheduling quantum
 
 #endif
\ No newline at end of file
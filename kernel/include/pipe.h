@@ -2,23 +2,37 @@
 #define __PIPE_H
 
 #include "types.h"
+#include "riscv.h"
 #include "spinlock.h"
 #include "file.h"
 
-#define PIPESIZE 512
+#define PIPEMAXPAGES 16   // extra pages a pipe may grow by
 
+// A pipe's ring starts in the rest of the page that holds
+// struct pipe and continues into whole pages in page[].
 struct pipe {
   struct spinlock lock;
-  char data[PIPESIZE];
-  uint nread;     // number of bytes read
-  uint nwrite;    // number of bytes written
-  int readopen;   // read fd is still open
-  int writeopen;  // write fd is still open
+  uint64 nread;     // number of bytes read
+  uint64 nwrite;    // number of bytes written
+  int readopen;     // read fd is still open
+  int writeopen;    // write fd is still open
+  int rbusy;        // a splice is copying out of the ring unlocked
+  int wbusy;        // a splice is copying into the ring unlocked
+  uint size;        // capacity of the ring in bytes
+  int npages;       // pages in use in page[]
+  char *page[PIPEMAXPAGES];
+  char data[];      // first part of the ring
 };
 
+// default capacity: what is left of the pipe's own page.
+#define PIPESIZE  (PGSIZE - sizeof(struct pipe))
+
 int pipealloc(struct file **f0, struct file **f1);
 void pipeclose(struct pipe *pi, int writable);
-int pipewrite(struct pipe *pi, uint64 addr, int n);
-int piperead(struct pipe *pi, uint64 addr, int n);
+int pipewrite(struct pipe *pi, int user, uint64 addr, int n);
+int piperead(struct pipe *pi, int user, uint64 addr, int n);
+int pipesetsize(struct pipe *pi, int n);
+int pipesplice(struct file *in, struct file *out, int n);
+int pipetee(struct pipe *in, struct pipe *out, int n);
 
-#endif
\ No newline at end of file
+#endif
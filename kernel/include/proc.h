@@ -35,6 +35,7 @@ struct cpu {
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  volatile int idle;          // In wfi in scheduler(); IPI it for new work.
 };
 
 extern struct cpu cpus[NCPU];
@@ -52,24 +53,46 @@ struct proc {
   int killed;                  // If non-zero, have been killed
   int xstate;                  // Exit status to be returned to parent's wait
   int pid;                     // Process ID
+  int nice;                    // Scheduling weight, NICE_MIN..NICE_MAX
+  int policy;                  // Scheduling class, SCHED_*
+  uint64 vruntime;             // CPU time received, scaled by weight
+  uint64 runtime;              // CPU time received, in r_time() units
+  uint64 lastrun;              // r_time() when last switched in
+  uint64 readyat;              // lat_begin() when last made RUNNABLE
+  uint64 affinity;             // Mask of harts p may run on
+  int lastcpu;                 // Hart p last ran on, or -1
+  struct proc *group;          // Thread-group leader; p itself unless p is a thread
+  int nthreads;                // Unreaped threads, if p is a group leader
+
+  // sleepq lock of the bucket chan hashes to must be held when using these:
+  struct proc *sqnext;         // Next sleeper in the same wait-channel bucket
+  struct proc *sqprev;         // Previous sleeper in the same bucket
+
+  // timer lock must be held when using these:
+  uint64 wakeat;               // If non-zero, r_time() to wake from a timed sleep
+  struct proc *tmnext;         // Next process in the sorted timer list
 
   // these are private to the process, so p->lock need not be held.
+  // A thread shares pagetable (and, through group, ofile and cwd)
+  // with the other threads of its group; see clone().
   uint64 kstack;               // Virtual address of kernel stack
   uint64 sz;                   // Size of process memory (bytes)
   pagetable_t pagetable;       // User page table
   pagetable_t kpagetable;      // Kernel page table
   struct trapframe *trapframe; // data page for trampoline.S
+  uint64 utrapframe;           // User virtual address trapframe is mapped at
   struct context context;      // swtch() here to run process
-  struct file *ofile[NOFILE];  // Open files
-  struct dirent *cwd;          // Current directory
+  struct file *ofile[NOFILE];  // Open files, used through group
+  struct dirent *cwd;          // Current directory, used through group
   char name[16];               // Process name (debugging)
-  int tmask;                    // trace mask
+  uint64 tmask;                 // trace mask, one bit per syscall number
 };
 
 void            reg_info(void);
 int             cpuid(void);
 void            exit(int);
 int             fork(void);
+int             clone(uint64 fn, uint64 arg, uint64 ustack);
 int             growproc(int);
 pagetable_t     proc_pagetable(struct proc *);
 void            proc_freepagetable(pagetable_t, uint64);
@@ -85,11 +108,19 @@ void            sleep(void*, struct spinlock*);
 void            userinit(void);
 int             wait(uint64);
 void            wakeup(void*);
+int             wakeupn(void*, int);
+int             futexwait(uint64 uaddr, int val);
+int             futexwake(uint64 uaddr, int n);
 void            yield(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
 uint64          procnum(void);
+uint64          sched_quantum(struct proc *p);
+int             setpriority(int pid, int nice);
+int             setscheduler(int pid, int policy);
+int             setaffinity(int pid, uint64 mask);
+int             getaffinity(int pid, uint64 *mask);
 void            test_proc_init(int);
 
 #endif
\ No newline at end of file
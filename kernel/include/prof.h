@@ -0,0 +1,29 @@
+#ifndef __PROF_H
+#define __PROF_H
+
+#include "types.h"
+
+// prof() operations
+#define PROF_START    0     // discard old samples and start sampling
+#define PROF_STOP     1     // stop; returns the number of samples dropped
+#define PROF_READ     2     // move up to n samples to buf; returns how many
+
+#define PROF_HZ       1000  // samples per second per busy hart
+#define PROF_NSAMPLE  2048  // samples buffered per hart
+#define PROF_NAME     16
+
+// One sample: where a hart was when the profiling timer fired.
+struct profsample {
+  uint64 pc;                // sepc at the interrupt
+  int pid;                  // 0 if the hart was idle
+  uchar cpu;
+  uchar user;               // 1 if pc is a user address
+  char name[PROF_NAME];     // the process's name, for its symbols
+};
+
+void            prof_init(void);
+int             prof_enabled(void);
+void            prof_sample(void);
+int             prof_ctl(int op, uint64 addr, int n);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef __SCHED_H
+#define __SCHED_H
+
+// scheduling classes, for setscheduler()
+#define SCHED_NORMAL    0   // fair share, short quantum, wake-up bonus
+#define SCHED_BATCH     1   // fair share, long quantum, no wake-up bonus
+#define NSCHEDCLASS     2
+
+// range of nice values, for setpriority()
+#define NICE_MIN      (-20)
+#define NICE_MAX        19
+
+#endif
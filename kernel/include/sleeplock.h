@@ -5,20 +5,42 @@
 #include "spinlock.h"
 
 struct spinlock;
+struct proc;
 
-// Long-term locks for processes
+// Long-term locks for processes.
+// A waiter spins for a moment while the holder is running on
+// another hart, and only sleeps if that doesn't pay off.
 struct sleeplock {
   uint locked;       // Is the lock held?
   struct spinlock lk; // spinlock protecting this sleep lock
+  struct proc *owner; // Process holding lock, for spinning
+  int waiters;       // Processes asleep on the lock
   
   // For debugging:
   char *name;        // Name of lock.
   int pid;           // Process holding lock
 };
 
+// Reader/writer sleep lock: any number of readers, or one writer.
+struct rwsleeplock {
+  struct spinlock lk; // spinlock protecting this lock
+  int readers;       // Readers holding the lock
+  struct proc *writer; // Writer holding the lock, if any
+  int rwaiting;      // Readers asleep, on &readers
+  int wwaiting;      // Writers asleep, on &writer
+  char *name;        // Name of lock.
+};
+
 void            acquiresleep(struct sleeplock*);
 void            releasesleep(struct sleeplock*);
 int             holdingsleep(struct sleeplock*);
 void            initsleeplock(struct sleeplock*, char*);
 
+void            acquireread(struct rwsleeplock*);
+void            releaseread(struct rwsleeplock*);
+void            acquirewrite(struct rwsleeplock*);
+void            releasewrite(struct rwsleeplock*);
+int             holdingwrite(struct rwsleeplock*);
+void            initrwsleeplock(struct rwsleeplock*, char*);
+
 #endif
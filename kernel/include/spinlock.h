@@ -1,20 +1,32 @@
 #ifndef __SPINLOCK_H
 #define __SPINLOCK_H
 
+#include "types.h"
+
 struct cpu;
+struct lockclass;
 
-// Mutual exclusion lock.
+// Mutual exclusion lock. A ticket lock: harts get the lock in
+// the order they asked for it.
 struct spinlock {
-  uint locked;       // Is the lock held?
+  uint next;         // Next ticket to hand out
+  uint owner;        // Ticket now holding the lock
 
   // For debugging:
   char *name;        // Name of lock.
   struct cpu *cpu;   // The cpu holding the lock.
+  struct lockclass *class;  // For lockstat; shared by name
+#ifdef LOCKSTAT
+  uint64 tacquire;   // r_time() when acquired
+#endif
 };
 
 // Initialize a spinlock 
 void initlock(struct spinlock*, char*);
 
+// Stop counting a lock that is about to be freed
+void freelock(struct spinlock*);
+
 // Acquire the spinlock
 // Must be used with release()
 void acquire(struct spinlock*);
@@ -27,4 +39,12 @@ void release(struct spinlock*);
 // Interrupts must be off 
 int holding(struct spinlock*);
 
+struct lockstat;
+
+// Copy out the counters of lock class i; 0 if there is none
+int lockstat_get(int i, struct lockstat*);
+
+// Zero all lock class counters
+void lockstat_reset(void);
+
 #endif
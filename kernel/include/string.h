@@ -15,4 +15,8 @@ void            snstr(char *dst, wchar const *src, int len);
 int             wcsncmp(wchar const *s1, wchar const *s2, int len);
 char*           strchr(const char *s, char c);
 
+#ifdef DEBUG
+void            string_selftest(void);
+#endif
+
 #endif
\ No newline at end of file
@@ -6,6 +6,7 @@
 struct sysinfo {
   uint64 freemem;   // amount of free memory (bytes)
   uint64 nproc;     // number of process
+  uint64 boottime;  // r_time() when the kernel was entered
 };
 
 
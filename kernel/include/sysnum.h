@@ -28,5 +28,23 @@
 #define SYS_readdir     24
 #define SYS_getcwd      25
 #define SYS_rename      26
+#define SYS_nanosleep   27
+#define SYS_setpriority 28
+#define SYS_setscheduler 29
+#define SYS_sched_setaffinity 30
+#define SYS_sched_getaffinity 31
+#define SYS_clone       32
+#define SYS_futex       33
+#define SYS_fcntl       34
+#define SYS_splice      35
+#define SYS_tee         36
+#define SYS_lockstat    37
+#define SYS_cpustat     38
+#define SYS_traceread   39
+#define SYS_prof        40
+#define SYS_latency     41
+#define SYS_lseek       42
+#define SYS_rdtime      43
+#define SYS_sched_yield 44
 
 #endif
\ No newline at end of file
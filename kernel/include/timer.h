@@ -4,11 +4,12 @@
 #include "types.h"
 #include "spinlock.h"
 
-extern struct spinlock tickslock;
-extern uint ticks;
+extern uint64 boot_entry;   // r_time() when hart 0 entered main()
 
 void timerinit();
 void set_next_timeout();
-void timer_tick();
+int timer_tick();
+uint64 timer_ticks(void);
+int timer_sleep_until(uint64 deadline);
 
 #endif
@@ -0,0 +1,26 @@
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include "types.h"
+
+#define TRACE_NARG    6
+#define TRACE_NREC    256     // records per hart
+
+// One traced system call, as returned by traceread().
+// Each hart keeps a ring of these, numbered by seq from 0 at
+// boot; a reader that falls behind sees a gap in seq.
+struct tracerec {
+  uint64 seq;               // position in its hart's ring
+  uint64 tenter;            // r_time() on entry
+  uint64 texit;             // r_time() on return (tenter for exit)
+  uint64 args[TRACE_NARG];  // a0..a5 on entry
+  uint64 ret;               // value returned in a0
+  int pid;
+  short num;                // system call number
+  short cpu;                // hart it returned on
+};
+
+void            trace_record(int num, uint64 *args, uint64 ret, uint64 tenter);
+int             trace_read(int cpu, uint64 from, uint64 addr, int n);
+
+#endif
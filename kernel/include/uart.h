@@ -0,0 +1,9 @@
+#ifndef __UART_H
+#define __UART_H
+
+void uartinit(void);
+void uartputc_sync(int c);
+void uartwrite(const char *s, int n);
+void uartintr(void);
+
+#endif
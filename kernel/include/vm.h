@@ -26,6 +26,8 @@ int             copyin(pagetable_t, char *, uint64, uint64);
 int             copyinstr(pagetable_t, char *, uint64, uint64);
 pagetable_t     proc_kpagetable(void);
 void            kvmfreeusr(pagetable_t kpt);
+int             kvmshareusr(pagetable_t kpt, pagetable_t knew);
+void            kvmunshareusr(pagetable_t kpt);
 void            kvmfree(pagetable_t kpagetable, int stack_free);
 uint64          kwalkaddr(pagetable_t pagetable, uint64 va);
 int             copyout2(uint64 dstva, char *src, uint64 len);
@@ -12,10 +12,16 @@
 #include "include/string.h"
 #include "include/printf.h"
 
-void freerange(void *pa_start, void *pa_end);
-
 extern char kernel_end[]; // first address after kernel.
 
+// At boot the free memory is cut into NSHARE shares, and every
+// hart that is up frees whichever shares it claims first, so
+// the harts split the work without depending on each other
+// being there.
+#define NSHARE    (NCPU * 4)
+static int claimed[NSHARE];
+static volatile int nfreed;
+
 struct run {
   struct run *next;
 };
@@ -26,26 +32,72 @@ struct {
   uint64 npage;
 } kmem;
 
+// Called by hart 0 before any hart calls kinithart().
 void
 kinit()
 {
   initlock(&kmem.lock, "kmem");
   kmem.freelist = 0;
   kmem.npage = 0;
-  freerange(kernel_end, (void*)PHYSTOP);
   #ifdef DEBUG
   printf("kernel_end: %p, phystop: %p\n", kernel_end, (void*)PHYSTOP);
   printf("kinit\n");
   #endif
 }
 
+// Put share s of the memory above the kernel on the free list.
+// The pages are chained up without the lock and spliced in at
+// once, and are not junk-filled as kfree() would: nothing can
+// hold a dangling pointer into memory never handed out, and
+// kalloc() fills each page anyway.
+static void
+freeshare(int s)
+{
+  uint64 start = PGROUNDUP((uint64)kernel_end);
+  uint64 npage = (PHYSTOP - start) / PGSIZE;
+  char *p = (char *)(start + npage * s / NSHARE * PGSIZE);
+  char *end = (char *)(start + npage * (s + 1) / NSHARE * PGSIZE);
+  struct run *head = 0, *tail = 0, *r;
+  uint64 n = 0;
+
+  for(; p < end; p += PGSIZE, n++){
+    r = (struct run *)p;
+    r->next = head;
+    head = r;
+    if(tail == 0)
+      tail = r;
+  }
+  if(head){
+    acquire(&kmem.lock);
+    tail->next = kmem.freelist;
+    kmem.freelist = head;
+    kmem.npage += n;
+    release(&kmem.lock);
+  }
+  __sync_fetch_and_add(&nfreed, 1);
+}
+
+// Free every share nobody else has claimed, starting with
+// this hart's own, so that two harts rarely contend.
+void
+kinithart(void)
+{
+  int first = r_tp() * NSHARE / NCPU;
+
+  for(int i = 0; i < NSHARE; i++){
+    int s = (first + i) % NSHARE;
+    if(__sync_bool_compare_and_swap(&claimed[s], 0, 1))
+      freeshare(s);
+  }
+}
+
+// Wait until every share is on the free list.
 void
-freerange(void *pa_start, void *pa_end)
+kinitwait(void)
 {
-  char *p;
-  p = (char*)PGROUNDUP((uint64)pa_start);
-  for(; p + PGSIZE <= (char*)pa_end; p += PGSIZE)
-    kfree(p);
+  while(nfreed < NSHARE)
+    ;
+  __sync_synchronize();
 }
 
 // Free the page of physical memory pointed at by v,
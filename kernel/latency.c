@@ -0,0 +1,81 @@
+// Latency histograms.
+//
+// Like cpustat, one set per hart: each hart adds only to its
+// own, atomically in case it is interrupted or moved mid-add,
+// and latency(LAT_GET) sums the harts.
+
+#include "include/types.h"
+#include "include/param.h"
+#include "include/riscv.h"
+#include "include/string.h"
+#include "include/vm.h"
+#include "include/latency.h"
+
+static struct lathist lats[NCPU][NLAT] __attribute__((aligned(64)));
+
+volatile int lat_on;
+
+// Count a time of t in histogram id.
+void
+lat_add(int id, uint64 t)
+{
+  struct lathist *h = &lats[r_tp()][id];
+  uint64 m, v;
+  int b;
+
+  for(b = 0, v = t >> 1; v != 0 && b < LAT_NBUCKET - 1; b++)
+    v >>= 1;
+  __sync_fetch_and_add(&h->count, 1);
+  __sync_fetch_and_add(&h->sum, t);
+  __sync_fetch_and_add(&h->bucket[b], 1);
+  while((m = h->max) < t && !__sync_bool_compare_and_swap(&h->max, m, t))
+    ;
+}
+
+// Count the time since t0, a lat_begin(), in histogram id.
+void
+lat_end(int id, uint64 t0)
+{
+  if(t0 != 0)
+    lat_add(id, r_time() - t0);
+}
+
+int
+lat_ctl(int op, int id, uint64 addr)
+{
+  struct lathist h;
+  uint64 *dst = (uint64 *)&h, *src;
+  int i, c, n = sizeof(h) / sizeof(uint64);
+
+  switch(op){
+  case LAT_GET:
+    if(id < 0 || id >= NLAT)
+      return -1;
+    memset(&h, 0, sizeof(h));
+    for(c = 0; c < NCPU; c++){
+      src = (uint64 *)&lats[c][id];
+      for(i = 0; i < n; i++){
+        if(&dst[i] == &h.max){
+          if(src[i] > h.max)
+            h.max = src[i];
+        } else
+          dst[i] += *(volatile uint64 *)&src[i];
+      }
+    }
+    if(copyout2(addr, (char *)&h, sizeof(h)) < 0)
+      return -1;
+    return NLAT;
+
+  case LAT_START:
+    lat_on = 0;
+    memset(lats, 0, sizeof(lats));
+    __sync_synchronize();
+    lat_on = 1;
+    return 0;
+
+  case LAT_STOP:
+    lat_on = 0;
+    return 0;
+  }
+  return -1;
+}
@@ -7,6 +7,7 @@
 #include "include/riscv.h"
 #include "include/sbi.h"
 #include "include/console.h"
+#include "include/uart.h"
 #include "include/printf.h"
 #include "include/kalloc.h"
 #include "include/timer.h"
@@ -16,6 +17,8 @@
 #include "include/vm.h"
 #include "include/disk.h"
 #include "include/buf.h"
+#include "include/string.h"
+#include "include/prof.h"
 #ifndef QEMU
 #include "include/sdcard.h"
 #include "include/fpioa.h"
@@ -26,24 +29,88 @@ static inline void inithartid(unsigned long hartid) {
   asm volatile("mv tp, %0" : : "r" (hartid & 0x1));
 }
 
+// Boot stages, as hart 0 reaches them; the other harts wait
+// for each before going on.
+#define BOOT_MEM      1     // free memory may be claimed (kinithart)
+#define BOOT_VM       2     // the kernel page table and devices are set up
 volatile static int started = 0;
 
+static int diskclaimed;     // someone has started disk_init()
+volatile static int diskready;
+
+// Timestamps of hart 0's boot phases, printed once it is done.
+static struct {
+  char *name;
+  uint64 time;
+} phases[12];
+static int nphase;
+
+static void
+phase(char *name)
+{
+  if (nphase < NELEM(phases)) {
+    phases[nphase].name = name;
+    phases[nphase].time = r_time();
+    nphase++;
+  }
+}
+
+static uint64
+us(uint64 t)
+{
+  return t * 1000000 / CLK_FREQ;
+}
+
+// The SD card takes long to come up on k210, so whichever hart
+// gets here first brings up the disk while hart 0 goes on.
+// Nobody may run a process, which might use the disk, until
+// it is up.
+static void
+diskinit(void)
+{
+  if (__sync_bool_compare_and_swap(&diskclaimed, 0, 1)) {
+    disk_init();
+    __sync_synchronize();
+    diskready = 1;
+  }
+  while (!diskready)
+    ;
+  __sync_synchronize();
+}
+
 void
 main(unsigned long hartid, unsigned long dtb_pa)
 {
   inithartid(hartid);
   
   if (hartid == 0) {
+    boot_entry = r_time();
     consoleinit();
     printfinit();   // init a lock for printf 
     print_logo();
     #ifdef DEBUG
     printf("hart %d enter main()...\n", hartid);
     #endif
+    // wake the other harts now, so they can help from here on.
+    for(int i = 1; i < NCPU; i++) {
+      unsigned long mask = 1 << i;
+      sbi_send_ipi(&mask);
+    }
+    phase("console");
     kinit();         // physical page allocator
+    __sync_synchronize();
+    started = BOOT_MEM;
+    kinithart();     // free memory, with the other harts
+    kinitwait();
+    phase("memory");
+    #ifdef DEBUG
+    string_selftest();
+    #endif
     kvminit();       // create kernel page table
     kvminithart();   // turn on paging
+    uartinit();      // console output to the UART, no longer SBI
     timerinit();     // init a lock for timer
+    prof_init();     // and one for the profiler's reader
     trapinithart();  // install kernel trap vector, including interrupt handler
     procinit();
     plicinit();
@@ -52,31 +119,39 @@ main(unsigned long hartid, unsigned long dtb_pa)
     fpioa_pin_init();
     dmac_init();
     #endif 
-    disk_init();
+    phase("vm, traps, plic");
+    __sync_synchronize();
+    started = BOOT_VM;
     binit();         // buffer cache
     fileinit();      // file table
     userinit();      // first user process
+    phase("bcache, files, init");
+    diskinit();      // or wait for the hart that has it in hand
+    phase("disk");
+
+    printf("boot:");
+    for (int i = 1; i < nphase; i++)
+      printf(" %s %dus,", phases[i].name, (int)us(phases[i].time - phases[i-1].time));
+    printf(" %dus since entry\n", (int)us(r_time() - boot_entry));
     printf("hart 0 init done\n");
-    
-    for(int i = 1; i < NCPU; i++) {
-      unsigned long mask = 1 << i;
-      sbi_send_ipi(&mask);
-    }
-    __sync_synchronize();
-    started = 1;
   }
   else
   {
     // hart 1
-    while (started == 0)
+    while (started < BOOT_MEM)
       ;
     __sync_synchronize();
     #ifdef DEBUG
     printf("hart %d enter main()...\n", hartid);
     #endif
+    kinithart();
+    while (started < BOOT_VM)
+      ;
+    __sync_synchronize();
     kvminithart();
     trapinithart();
     plicinithart();  // ask PLIC for device interrupts
+    diskinit();
     printf("hart 1 init done\n");
   }
   scheduler();
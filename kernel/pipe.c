@@ -9,6 +9,7 @@
 #include "include/pipe.h"
 #include "include/kalloc.h"
 #include "include/vm.h"
+#include "include/fat32.h"
 
 int
 pipealloc(struct file **f0, struct file **f1)
@@ -25,6 +26,10 @@ pipealloc(struct file **f0, struct file **f1)
   pi->writeopen = 1;
   pi->nwrite = 0;
   pi->nread = 0;
+  pi->size = PIPESIZE;
+  pi->npages = 0;
+  pi->rbusy = 0;
+  pi->wbusy = 0;
   initlock(&pi->lock, "pipe");
   (*f0)->type = FD_PIPE;
   (*f0)->readable = 1;
@@ -59,62 +64,366 @@ pipeclose(struct pipe *pi, int writable)
   }
   if(pi->readopen == 0 && pi->writeopen == 0){
     release(&pi->lock);
+    freelock(&pi->lock);
+    for(int i = 0; i < pi->npages; i++)
+      kfree(pi->page[i]);
     kfree((char*)pi);
   } else
     release(&pi->lock);
 }
 
+// Return where byte off of pi's ring lives, setting *n
+// to how many bytes from there on are contiguous.
+static char *
+pipebuf(struct pipe *pi, uint64 off, uint *n)
+{
+  uint o = off % pi->size;
+
+  if(o < PIPESIZE){
+    *n = PIPESIZE - o;
+    return pi->data + o;
+  }
+  o -= PIPESIZE;
+  *n = PGSIZE - o % PGSIZE;
+  return pi->page[o / PGSIZE] + o % PGSIZE;
+}
+
+// Reverse bytes [from, to) of pi's ring, for pipesetsize().
+static void
+pipereverse(struct pipe *pi, uint64 from, uint64 to)
+{
+  uint n;
+  char *a, *b, c;
+
+  while(from + 1 < to){
+    a = pipebuf(pi, from++, &n);
+    b = pipebuf(pi, --to, &n);
+    c = *a;
+    *a = *b;
+    *b = c;
+  }
+}
+
+// Resize pi's ring to hold at least n bytes, keeping any
+// buffered data. Return the new capacity, or -1 if n is too
+// large or smaller than what is buffered.
+int
+pipesetsize(struct pipe *pi, int n)
+{
+  char *pages[PIPEMAXPAGES];
+  int npages, nfree = 0;
+  uint64 len, start;
+
+  if(n < 0)
+    return -1;
+  npages = n <= PIPESIZE ? 0 : (n - PIPESIZE + PGSIZE - 1) / PGSIZE;
+  if(npages > PIPEMAXPAGES)
+    return -1;
+
+  // Allocate outside the lock the pages we may need.
+  for(int i = 0; i < npages; i++){
+    if((pages[i] = kalloc()) == NULL){
+      while(--i >= 0)
+        kfree(pages[i]);
+      return -1;
+    }
+  }
+
+  acquire(&pi->lock);
+  // Splices copy in and out of the ring unlocked.
+  while(pi->rbusy || pi->wbusy)
+    sleep(pi->rbusy ? (void*)&pi->rbusy : (void*)&pi->wbusy, &pi->lock);
+  len = pi->nwrite - pi->nread;
+  if(len > PIPESIZE + npages * PGSIZE){
+    release(&pi->lock);
+    for(int i = 0; i < npages; i++)
+      kfree(pages[i]);
+    return -1;
+  }
+
+  // Rotate the buffered bytes to the start of the ring, which
+  // is laid out the same way whatever its size.
+  start = pi->nread % pi->size;
+  if(start != 0){
+    pipereverse(pi, 0, start);
+    pipereverse(pi, start, pi->size);
+    pipereverse(pi, 0, pi->size);
+  }
+  pi->nread = 0;
+  pi->nwrite = len;
+
+  // Keep the pages that already hold data, and swap the
+  // rest with the new ones (to free after unlocking).
+  for(int i = 0; i < PIPEMAXPAGES; i++){
+    if(i < npages && i < pi->npages){
+      pages[nfree++] = pages[i];
+    } else if(i < npages){
+      pi->page[i] = pages[i];
+    } else if(i < pi->npages){
+      pages[nfree++] = pi->page[i];
+    }
+  }
+  pi->npages = npages;
+  pi->size = PIPESIZE + npages * PGSIZE;
+  n = pi->size;
+  // Writers may have room now.
+  wakeup(&pi->nwrite);
+  release(&pi->lock);
+
+  for(int i = 0; i < nfree; i++)
+    kfree(pages[i]);
+  return n;
+}
+
+// Copy n bytes from addr (a user address if user) into pi.
 int
-pipewrite(struct pipe *pi, uint64 addr, int n)
+pipewrite(struct pipe *pi, int user, uint64 addr, int n)
 {
   int i;
-  char ch;
+  uint m, contig;
+  char *buf;
   struct proc *pr = myproc();
 
   acquire(&pi->lock);
-  for(i = 0; i < n; i++){
-    while(pi->nwrite == pi->nread + PIPESIZE){  //DOC: pipewrite-full
+  for(i = 0; i < n; i += m){
+    while(pi->nwrite == pi->nread + pi->size || pi->wbusy){  //DOC: pipewrite-full
       if(pi->readopen == 0 || pr->killed){
         release(&pi->lock);
         return -1;
       }
-      wakeup(&pi->nread);
-      sleep(&pi->nwrite, &pi->lock);
+      sleep(pi->wbusy ? (void*)&pi->wbusy : (void*)&pi->nwrite, &pi->lock);
     }
-    // if(copyin(pr->pagetable, &ch, addr + i, 1) == -1)
-    if(copyin2(&ch, addr + i, 1) == -1)
+    // Copy as much as fits before the ring wraps, fills, or
+    // crosses into another page.
+    buf = pipebuf(pi, pi->nwrite, &contig);
+    m = n - i;
+    if(m > pi->size - (pi->nwrite - pi->nread))
+      m = pi->size - (pi->nwrite - pi->nread);
+    if(m > contig)
+      m = contig;
+    if(either_copyin(buf, user, addr + i, m) == -1)
       break;
-    pi->data[pi->nwrite++ % PIPESIZE] = ch;
+    // A reader only sleeps on an empty pipe.
+    if(pi->nwrite == pi->nread)
+      wakeup(&pi->nread);
+    pi->nwrite += m;
   }
-  wakeup(&pi->nread);
   release(&pi->lock);
   return i;
 }
 
+// Copy up to n bytes out of pi to addr (a user address if user).
 int
-piperead(struct pipe *pi, uint64 addr, int n)
+piperead(struct pipe *pi, int user, uint64 addr, int n)
 {
   int i;
+  uint m, contig;
+  char *buf;
   struct proc *pr = myproc();
-  char ch;
 
   acquire(&pi->lock);
-  while(pi->nread == pi->nwrite && pi->writeopen){  //DOC: pipe-empty
+  while((pi->nread == pi->nwrite && pi->writeopen) || pi->rbusy){  //DOC: pipe-empty
     if(pr->killed){
       release(&pi->lock);
       return -1;
     }
-    sleep(&pi->nread, &pi->lock); //DOC: piperead-sleep
+    sleep(pi->rbusy ? (void*)&pi->rbusy : (void*)&pi->nread, &pi->lock); //DOC: piperead-sleep
   }
-  for(i = 0; i < n; i++){  //DOC: piperead-copy
-    if(pi->nread == pi->nwrite)
-      break;
-    ch = pi->data[pi->nread++ % PIPESIZE];
-    // if(copyout(pr->pagetable, addr + i, &ch, 1) == -1)
-    if(copyout2(addr + i, &ch, 1) == -1)
+  for(i = 0; i < n && pi->nread != pi->nwrite; i += m){  //DOC: piperead-copy
+    // Copy up to the end of the data or of this piece of the ring.
+    buf = pipebuf(pi, pi->nread, &contig);
+    m = n - i;
+    if(m > pi->nwrite - pi->nread)
+      m = pi->nwrite - pi->nread;
+    if(m > contig)
+      m = contig;
+    if(either_copyout(user, addr + i, buf, m) == -1)
       break;
+    // A writer only sleeps on a full pipe.
+    if(pi->nwrite == pi->nread + pi->size)
+      wakeup(&pi->nwrite);  //DOC: piperead-wakeup
+    pi->nread += m;
   }
-  wakeup(&pi->nwrite);  //DOC: piperead-wakeup
   release(&pi->lock);
   return i;
 }
+
+// Claim the contiguous run of buffered bytes that starts skip
+// bytes past the read end, at most n of them, so the caller
+// can copy them out without holding pi->lock (e.g. into a file,
+// which may sleep). Waits for data only if wait is set.
+// Return the run's length, 0 at end of data, or -1 if killed.
+// A nonzero return must be followed by piperend().
+static int
+piperbegin(struct pipe *pi, uint skip, int n, int wait, char **buf)
+{
+  uint m, contig;
+  struct proc *pr = myproc();
+
+  acquire(&pi->lock);
+  while(pi->rbusy ||
+        (wait && pi->nwrite - pi->nread <= skip && pi->writeopen)){
+    if(pr->killed){
+      release(&pi->lock);
+      return -1;
+    }
+    sleep(pi->rbusy ? (void*)&pi->rbusy : (void*)&pi->nread, &pi->lock);
+  }
+  if(pi->nwrite - pi->nread <= skip){
+    release(&pi->lock);
+    return 0;
+  }
+  *buf = pipebuf(pi, pi->nread + skip, &contig);
+  m = pi->nwrite - pi->nread - skip;
+  if(m > n)
+    m = n;
+  if(m > contig)
+    m = contig;
+  pi->rbusy = 1;
+  release(&pi->lock);
+  return m;
+}
+
+// Finish a piperbegin(), consuming the first n bytes if consume.
+static void
+piperend(struct pipe *pi, int n, int consume)
+{
+  acquire(&pi->lock);
+  if(consume && n > 0){
+    if(pi->nwrite == pi->nread + pi->size)
+      wakeup(&pi->nwrite);
+    pi->nread += n;
+  }
+  pi->rbusy = 0;
+  wakeup(&pi->rbusy);
+  release(&pi->lock);
+}
+
+// Claim a contiguous run of free space of at most n bytes at
+// the write end, so the caller can fill it without holding
+// pi->lock. Return its length, or -1 if the pipe has no
+// reader or we are killed.
+// A nonzero return must be followed by pipewend().
+static int
+pipewbegin(struct pipe *pi, int n, char **buf)
+{
+  uint m, contig;
+  struct proc *pr = myproc();
+
+  acquire(&pi->lock);
+  while(pi->nwrite == pi->nread + pi->size || pi->wbusy){
+    if(pi->readopen == 0 || pr->killed){
+      release(&pi->lock);
+      return -1;
+    }
+    sleep(pi->wbusy ? (void*)&pi->wbusy : (void*)&pi->nwrite, &pi->lock);
+  }
+  if(pi->readopen == 0 || pr->killed){
+    release(&pi->lock);
+    return -1;
+  }
+  *buf = pipebuf(pi, pi->nwrite, &contig);
+  m = pi->size - (pi->nwrite - pi->nread);
+  if(m > n)
+    m = n;
+  if(m > contig)
+    m = contig;
+  pi->wbusy = 1;
+  release(&pi->lock);
+  return m;
+}
+
+// Finish a pipewbegin(), publishing the first n bytes.
+static void
+pipewend(struct pipe *pi, int n)
+{
+  acquire(&pi->lock);
+  if(n > 0){
+    if(pi->nwrite == pi->nread)
+      wakeup(&pi->nread);
+    pi->nwrite += n;
+  }
+  pi->wbusy = 0;
+  wakeup(&pi->wbusy);
+  release(&pi->lock);
+}
+
+// Move up to n bytes from in to out inside the kernel, where
+// at least one of them is a pipe and the other a pipe or a
+// file. File data goes straight between the buffer cache and
+// the pipe's ring. Like read(), blocks only until some data
+// has moved. Return the number of bytes moved, or -1.
+int
+pipesplice(struct file *in, struct file *out, int n)
+{
+  int tot, m, r;
+  char *buf;
+
+  if(in->type == FD_PIPE && out->type == FD_PIPE && in->pipe == out->pipe)
+    return -1;
+  // Only regular files; eread() of a directory would look like EOF.
+  if((in->type == FD_ENTRY && (in->ep->attribute & ATTR_DIRECTORY)) ||
+     (out->type == FD_ENTRY && (out->ep->attribute & ATTR_DIRECTORY)))
+    return -1;
+
+  if(in->type == FD_ENTRY){
+    // file -> pipe
+    for(tot = 0; tot < n; tot += r){
+      if((m = pipewbegin(out->pipe, n - tot, &buf)) < 0)
+        return tot > 0 ? tot : -1;
+      elock(in->ep);
+      if((r = eread(in->ep, 0, (uint64)buf, in->off, m)) > 0)
+        in->off += r;
+      eunlock(in->ep);
+      pipewend(out->pipe, r > 0 ? r : 0);
+      if(r < 0)
+        return tot > 0 ? tot : -1;
+      if(r < m)
+        return tot + r;   // end of file
+    }
+    return tot;
+  }
+
+  // pipe -> file or pipe
+  for(tot = 0; tot < n; tot += r){
+    if((m = piperbegin(in->pipe, 0, n - tot, tot == 0, &buf)) <= 0)
+      return tot > 0 ? tot : m;
+    if(out->type == FD_ENTRY){
+      elock(out->ep);
+      if((r = ewrite(out->ep, 0, (uint64)buf, out->off, m)) > 0)
+        out->off += r;
+      eunlock(out->ep);
+    } else {
+      r = pipewrite(out->pipe, 0, (uint64)buf, m);
+    }
+    piperend(in->pipe, r > 0 ? r : 0, 1);
+    if(r < 0)
+      return tot > 0 ? tot : -1;
+    if(r < m)
+      return tot + r;
+  }
+  return tot;
+}
+
+// Copy up to n bytes from pipe in to pipe out without
+// consuming them from in. Return the number copied, or -1.
+int
+pipetee(struct pipe *in, struct pipe *out, int n)
+{
+  int tot, m, r;
+  char *buf;
+
+  if(in == out)
+    return -1;
+  for(tot = 0; tot < n; tot += r){
+    if((m = piperbegin(in, tot, n - tot, tot == 0, &buf)) <= 0)
+      return tot > 0 ? tot : m;
+    r = pipewrite(out, 0, (uint64)buf, m);
+    piperend(in, 0, 0);
+    if(r < 0)
+      return tot > 0 ? tot : -1;
+    if(r < m)
+      return tot + r;
+  }
+  return tot;
+}
@@ -13,6 +13,11 @@
 #include "include/file.h"
 #include "include/trap.h"
 #include "include/vm.h"
+#include "include/timer.h"
+#include "include/sched.h"
+#include "include/cpustat.h"
+#include "include/latency.h"
+#include "include/sbi.h"
 
 
 struct cpu cpus[NCPU];
@@ -24,10 +29,68 @@ struct proc *initproc;
 int nextpid = 1;
 struct spinlock pid_lock;
 
+// Taken around a futex's check-and-sleep and its wakeups,
+// so a FUTEX_WAKE can't slip in between the two.
+struct spinlock futex_lock;
+
+// Serializes changes to the page tables and sizes that the
+// threads of a group share, and each leader's nthreads.
+struct spinlock tglock;
+
+// Sleeping processes are hashed by chan into these buckets,
+// so that wakeup() only looks at processes that may be
+// waiting on its chan instead of scanning the whole proc[].
+//
+// Lock order: a bucket's lock before any p->lock. The one
+// exception is sleep(chan, &p->lock) (wait(), reapthreads()),
+// which takes its bucket's lock while holding its own p->lock.
+// That cannot deadlock: wakeupn() only takes the p->lock of a
+// process that is in the bucket with a matching chan, and p
+// is in no bucket until sleep() has put it there under the
+// bucket lock. Nobody may call wakeup() holding a p->lock.
+struct sleepq {
+  struct spinlock lock;
+  struct proc *head;
+} sleepq[NSLEEPQ];
+
+// Weight of each nice level, NICE_MIN first; nice 0 is 1024
+// and each step is worth about 10% of CPU time.
+static const uint sched_weight[NICE_MAX - NICE_MIN + 1] = {
+  88761, 71755, 56483, 46273, 36291,
+  29154, 23254, 18705, 14949, 11916,
+  9548,  7620,  6100,  4904,  3906,
+  3121,  2501,  1991,  1586,  1277,
+  1024,  820,   655,   526,   423,
+  335,   272,   215,   172,   137,
+  110,   87,    70,    56,    45,
+  36,    29,    23,    18,    15,
+};
+
+// Time slice of each scheduling class.
+static const uint64 sched_slice[NSCHEDCLASS] = {
+  [SCHED_NORMAL]  INTERVAL,
+  [SCHED_BATCH]   4 * INTERVAL,
+};
+
+// How much vruntime a process that last ran on another hart
+// has to be behind before we pull it over, so that cache-hot
+// processes tend to stay on the hart they last ran on.
+#define SCHED_MIGRATE_COST  (INTERVAL / 2)
+
+#define AFFINITY_ALL  ((1UL << NCPU) - 1)
+
+// Roughly the smallest vruntime among runnable processes.
+// New and waking processes start from here, so they can't
+// claim CPU time they did not wait for. Updated without a
+// lock; it only has to be close.
+static uint64 min_vruntime;
+
 extern void forkret(void);
 extern void swtch(struct context*, struct context*);
 static void wakeup1(struct proc *chan);
 static void freeproc(struct proc *p);
+static void wakeproc(struct proc *p);
+static void kickidle(struct proc *p);
 
 extern char trampoline[]; // trampoline.S
 
@@ -54,6 +117,12 @@ procinit(void)
   struct proc *p;
   
   initlock(&pid_lock, "nextpid");
+  initlock(&tglock, "tgroup");
+  initlock(&futex_lock, "futex");
+  for(int i = 0; i < NSLEEPQ; i++) {
+    initlock(&sleepq[i].lock, "sleepq");
+    sleepq[i].head = NULL;
+  }
   for(p = proc; p < &proc[NPROC]; p++) {
       initlock(&p->lock, "proc");
 
@@ -140,6 +209,15 @@ allocproc(void)
 
 found:
   p->pid = allocpid();
+  p->nice = 0;
+  p->policy = SCHED_NORMAL;
+  p->vruntime = min_vruntime;
+  p->runtime = 0;
+  p->affinity = AFFINITY_ALL;
+  p->lastcpu = -1;
+  p->group = p;
+  p->nthreads = 0;
+  p->utrapframe = TRAPFRAME;
 
   // Allocate a trapframe page.
   if((p->trapframe = (struct trapframe *)kalloc()) == NULL){
@@ -173,6 +251,17 @@ found:
 static void
 freeproc(struct proc *p)
 {
+  if(p->group != p && p->group != NULL){
+    // A thread: give back only what is its own.
+    acquire(&tglock);
+    vmunmap(p->pagetable, p->utrapframe, 1, 0);
+    p->group->nthreads--;
+    release(&tglock);
+    kvmunshareusr(p->kpagetable);
+    p->pagetable = 0;
+    p->sz = 0;
+  }
+  p->group = 0;
   if(p->trapframe)
     kfree((void*)p->trapframe);
   p->trapframe = 0;
@@ -190,6 +279,7 @@ freeproc(struct proc *p)
   p->chan = 0;
   p->killed = 0;
   p->xstate = 0;
+  p->affinity = AFFINITY_ALL;
   p->state = UNUSED;
 }
 
@@ -301,6 +391,7 @@ userinit(void)
   safestrcpy(p->name, "initcode", sizeof(p->name));
 
   p->state = RUNNABLE;
+  p->readyat = lat_begin();
 
   p->tmask = 0;
 
@@ -316,17 +407,39 @@ int
 growproc(int n)
 {
   uint sz;
-  struct proc *p = myproc();
+  struct proc *p = myproc(), *q;
+  struct proc *g = p->group;
+
+  // Only a group's own threads can add to nthreads,
+  // so a lone process can't become shared under us.
+  if(g == p && p->nthreads == 0){
+    sz = p->sz;
+    if(n > 0){
+      if((sz = uvmalloc(p->pagetable, p->kpagetable, sz, sz + n)) == 0) {
+        return -1;
+      }
+    } else if(n < 0){
+      sz = uvmdealloc(p->pagetable, p->kpagetable, sz, sz + n);
+    }
+    p->sz = sz;
+    return 0;
+  }
 
+  // Other threads may be running on other harts with the
+  // pages in their TLBs, and there is no way to shoot those
+  // down, so a shared address space only grows.
+  if(n < 0)
+    return -1;
+  acquire(&tglock);
   sz = p->sz;
-  if(n > 0){
-    if((sz = uvmalloc(p->pagetable, p->kpagetable, sz, sz + n)) == 0) {
-      return -1;
-    }
-  } else if(n < 0){
-    sz = uvmdealloc(p->pagetable, p->kpagetable, sz, sz + n);
+  if(n > 0 && (sz = uvmalloc(p->pagetable, p->kpagetable, sz, sz + n)) == 0) {
+    release(&tglock);
+    return -1;
   }
-  p->sz = sz;
+  for(q = proc; q < &proc[NPROC]; q++)
+    if(q->group == g)
+      q->sz = sz;
+  release(&tglock);
   return 0;
 }
 
@@ -357,6 +470,13 @@ fork(void)
   // copy tracing mask from parent.
   np->tmask = p->tmask;
 
+  // inherit scheduling parameters.
+  np->nice = p->nice;
+  np->policy = p->policy;
+  np->affinity = p->affinity;
+  if(p->vruntime > np->vruntime)
+    np->vruntime = p->vruntime;
+
   // copy saved user registers.
   *(np->trapframe) = *(p->trapframe);
 
@@ -365,21 +485,118 @@ fork(void)
 
   // increment reference counts on open file descriptors.
   for(i = 0; i < NOFILE; i++)
-    if(p->ofile[i])
-      np->ofile[i] = filedup(p->ofile[i]);
-  np->cwd = edup(p->cwd);
+    if(p->group->ofile[i])
+      np->ofile[i] = filedup(p->group->ofile[i]);
+  np->cwd = edup(p->group->cwd);
 
   safestrcpy(np->name, p->name, sizeof(p->name));
 
   pid = np->pid;
 
   np->state = RUNNABLE;
+  np->readyat = lat_begin();
+  kickidle(np);
 
   release(&np->lock);
 
   return pid;
 }
 
+// Create a thread of the calling process that starts at fn(arg)
+// on the user stack ending at ustack. It shares the address space,
+// open files and current directory of the caller's group, and is
+// a child of the group leader, which reaps it with wait().
+// Return the new thread's pid, or -1.
+int
+clone(uint64 fn, uint64 arg, uint64 ustack)
+{
+  struct proc *np;
+  struct proc *p = myproc();
+  struct proc *g = p->group;
+  int tid;
+
+  if((np = allocproc()) == NULL){
+    return -1;
+  }
+
+  // Trade the fresh address space allocproc() made for the group's.
+  proc_freepagetable(np->pagetable, 0);
+  np->pagetable = g->pagetable;
+  np->utrapframe = TTRAPFRAME(np - proc);
+  acquire(&tglock);
+  if(kvmshareusr(g->kpagetable, np->kpagetable) < 0 ||
+     mappages(np->pagetable, np->utrapframe, PGSIZE,
+              (uint64)np->trapframe, PTE_R | PTE_W) < 0){
+    release(&tglock);
+    kvmunshareusr(np->kpagetable);
+    np->pagetable = 0;
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+  np->sz = p->sz;
+  np->group = g;
+  g->nthreads++;
+  release(&tglock);
+
+  np->parent = g;
+  np->tmask = p->tmask;
+  np->nice = p->nice;
+  np->policy = p->policy;
+  np->affinity = p->affinity;
+  if(p->vruntime > np->vruntime)
+    np->vruntime = p->vruntime;
+
+  *(np->trapframe) = *(p->trapframe);
+  np->trapframe->epc = fn;
+  np->trapframe->a0 = arg;
+  np->trapframe->sp = ustack;
+  np->trapframe->ra = 0;
+
+  safestrcpy(np->name, p->name, sizeof(p->name));
+
+  tid = np->pid;
+
+  np->state = RUNNABLE;
+  np->readyat = lat_begin();
+  kickidle(np);
+
+  release(&np->lock);
+
+  return tid;
+}
+
+// Kill the threads of group leader p and wait until they are
+// all reaped; they run in p's address space, which is about to
+// go away.
+static void
+reapthreads(struct proc *p)
+{
+  struct proc *q;
+
+  acquire(&p->lock);
+  while(p->nthreads > 0){
+    for(q = proc; q < &proc[NPROC]; q++){
+      // threads never leave a group, and only p reaps them,
+      // so q->group can't change to or from p under us.
+      if(q == p || q->group != p)
+        continue;
+      acquire(&q->lock);
+      if(q->state == ZOMBIE){
+        freeproc(q);
+      } else {
+        q->killed = 1;
+        if(q->state == SLEEPING)
+          wakeproc(q);
+      }
+      release(&q->lock);
+    }
+    if(p->nthreads > 0)
+      sleep(p, &p->lock);
+  }
+  release(&p->lock);
+}
+
 // Pass p's abandoned children to init.
 // Caller must hold p->lock.
 void
@@ -417,17 +634,24 @@ exit(int status)
   if(p == initproc)
     panic("init exiting");
 
-  // Close all open files.
-  for(int fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd]){
-      struct file *f = p->ofile[fd];
-      fileclose(f);
-      p->ofile[fd] = 0;
+  // Files and cwd belong to the group, so only its
+  // leader releases them, once its threads are gone.
+  if(p->group == p){
+    if(p->nthreads > 0)
+      reapthreads(p);
+
+    // Close all open files.
+    for(int fd = 0; fd < NOFILE; fd++){
+      if(p->ofile[fd]){
+        struct file *f = p->ofile[fd];
+        fileclose(f);
+        p->ofile[fd] = 0;
+      }
     }
-  }
 
-  eput(p->cwd);
-  p->cwd = 0;
+    eput(p->cwd);
+    p->cwd = 0;
+  }
 
   // we might re-parent a child to init. we can't be precise about
   // waking up init, since we can't acquire its lock once we've
@@ -526,52 +750,137 @@ wait(uint64 addr)
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
 // Scheduler never returns.  It loops, doing:
-//  - choose a process to run.
+//  - choose the runnable process allowed on this hart
+//    with the least vruntime, preferring ones that last
+//    ran here.
 //  - swtch to start running that process.
 //  - eventually that process transfers control
 //    via swtch back to the scheduler.
+//  - charge the time it ran, scaled by its weight.
 void
 scheduler(void)
 {
-  struct proc *p;
+  struct proc *p, *best;
   struct cpu *c = mycpu();
+  int id = cpuid();
+  uint64 v, bestv = 0;
   extern pagetable_t kernel_pagetable;
 
   c->proc = 0;
   for(;;){
     // Avoid deadlock by ensuring that devices can interrupt.
     intr_on();
-    
-    int found = 0;
+
+    // Peek without locks; the choice is rechecked under p->lock.
+    best = 0;
     for(p = proc; p < &proc[NPROC]; p++) {
-      acquire(&p->lock);
-      if(p->state == RUNNABLE) {
-        // Switch to chosen process.  It is the process's job
-        // to release its lock and then reacquire it
-        // before jumping back to us.
-        // printf("[scheduler]found runnable proc with pid: %d\n", p->pid);
-        p->state = RUNNING;
-        c->proc = p;
-        w_satp(MAKE_SATP(p->kpagetable));
-        sfence_vma();
-        swtch(&c->context, &p->context);
-        w_satp(MAKE_SATP(kernel_pagetable));
-        sfence_vma();
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-        c->proc = 0;
-
-        found = 1;
+      if(p->state != RUNNABLE || !(p->affinity & (1UL << id)))
+        continue;
+      v = p->vruntime;
+      if(p->lastcpu >= 0 && p->lastcpu != id)
+        v += SCHED_MIGRATE_COST;
+      if(best == 0 || v < bestv) {
+        best = p;
+        bestv = v;
       }
-      release(&p->lock);
     }
-    if(found == 0) {
-      intr_on();
-      asm volatile("wfi");
+
+    if(best == 0) {
+      // nothing to run: only wake for a deadline, a device, or
+      // an IPI from a hart that makes a process runnable. Look
+      // once more after saying we are idle, so that either we
+      // see its process or it sees us idle (see kickidle()).
+      c->idle = 1;
+      __sync_synchronize();
+      for(p = proc; p < &proc[NPROC]; p++)
+        if(p->state == RUNNABLE && (p->affinity & (1UL << id)))
+          break;
+      if(p == &proc[NPROC]) {
+        set_next_timeout();
+        intr_on();
+        asm volatile("wfi");
+      }
+      c->idle = 0;
+      continue;
+    }
+
+    p = best;
+    acquire(&p->lock);
+    if(p->state == RUNNABLE && (p->affinity & (1UL << id))) {
+      // Switch to chosen process.  It is the process's job
+      // to release its lock and then reacquire it
+      // before jumping back to us.
+      if(p->vruntime > min_vruntime)
+        min_vruntime = p->vruntime;
+      p->state = RUNNING;
+      c->proc = p;
+      p->lastcpu = id;
+      p->lastrun = r_time();
+      if(p->readyat != 0 && lat_on)
+        lat_add(LAT_RUNQ, p->lastrun - p->readyat);
+      set_next_timeout();   // start a quantum of p's class
+      w_satp(MAKE_SATP(p->kpagetable));
+      sfence_vma();
+      CPUSTAT_INC(ctxsw);
+      swtch(&c->context, &p->context);
+      w_satp(MAKE_SATP(kernel_pagetable));
+      sfence_vma();
+      // Process is done running for now.
+      // It should have changed its p->state before coming back.
+      c->proc = 0;
+
+      uint64 delta = r_time() - p->lastrun;
+      p->runtime += delta;
+      p->vruntime += delta * sched_weight[-NICE_MIN] / sched_weight[p->nice - NICE_MIN];
     }
+    release(&p->lock);
   }
 }
 
+// Length of the time slice p gets each time it is scheduled.
+uint64
+sched_quantum(struct proc *p)
+{
+  return sched_slice[p->policy];
+}
+
+// p has just become RUNNABLE: IPI a hart that is idle in
+// scheduler() and may run p, since an idle hart sleeps in wfi
+// with no timer to wake it. Caller must hold p->lock.
+static void
+kickidle(struct proc *p)
+{
+  int me = cpuid();
+
+  __sync_synchronize();
+  for(int i = 0; i < NCPU; i++){
+    if(i != me && cpus[i].idle && (p->affinity & (1UL << i))){
+      unsigned long mask = 1UL << i;
+      sbi_send_ipi(&mask);
+      return;
+    }
+  }
+}
+
+// Make a sleeping p runnable.
+// A normal-class process that slept gets at most one slice
+// of credit over the busiest runnable process, so interactive
+// programs run soon after waking without starving anyone.
+// Caller must hold p->lock.
+static void
+wakeproc(struct proc *p)
+{
+  uint64 floor = min_vruntime;
+
+  if(p->policy == SCHED_NORMAL)
+    floor = floor > INTERVAL ? floor - INTERVAL : 0;
+  if(p->vruntime < floor)
+    p->vruntime = floor;
+  p->state = RUNNABLE;
+  p->readyat = lat_begin();
+  kickidle(p);
+}
+
 // Switch to scheduler.  Must hold only p->lock
 // and have changed proc->state. Saves and restores
 // intena because intena is a property of this
@@ -606,6 +915,11 @@ yield(void)
   struct proc *p = myproc();
   acquire(&p->lock);
   p->state = RUNNABLE;
+  p->readyat = lat_begin();
+  // if p may no longer run here (see setaffinity()), a hart
+  // that it may run on could be idle.
+  if(!(p->affinity & (1UL << cpuid())))
+    kickidle(p);
   sched();
   release(&p->lock);
 }
@@ -634,13 +948,48 @@ forkret(void)
   usertrapret();
 }
 
+static struct sleepq*
+sleepq_of(void *chan)
+{
+  uint64 h = (uint64)chan * 0x9e3779b97f4a7c15UL;
+  return &sleepq[(h >> 32) % NSLEEPQ];
+}
+
+// Unlink p from bucket q.
+// Caller must hold q->lock.
+static void
+sleepq_remove(struct sleepq *q, struct proc *p)
+{
+  if(p->sqprev)
+    p->sqprev->sqnext = p->sqnext;
+  else
+    q->head = p->sqnext;
+  if(p->sqnext)
+    p->sqnext->sqprev = p->sqprev;
+  p->sqnext = p->sqprev = NULL;
+  p->chan = 0;
+}
+
 // Atomically release lock and sleep on chan.
 // Reacquires lock when awakened.
 void
 sleep(void *chan, struct spinlock *lk)
 {
   struct proc *p = myproc();
-  
+  struct sleepq *q = sleepq_of(chan);
+
+  // Put ourselves in chan's bucket before releasing lk.
+  // wakeup() callers hold lk, so they either run before
+  // we got here or find us in the bucket. The bucket lock
+  // is taken before p->lock, the same order wakeup() uses.
+  acquire(&q->lock);
+  p->chan = chan;
+  p->sqprev = NULL;
+  p->sqnext = q->head;
+  if(q->head)
+    q->head->sqprev = p;
+  q->head = p;
+
   // Must acquire p->lock in order to
   // change p->state and then call sched.
   // Once we hold p->lock, we can be
@@ -653,35 +1002,119 @@ sleep(void *chan, struct spinlock *lk)
   }
 
   // Go to sleep.
-  p->chan = chan;
   p->state = SLEEPING;
+  release(&q->lock);
 
   sched();
 
-  // Tidy up.
-  p->chan = 0;
+  // Tidy up. wakeup() has already unlinked us, unless we were
+  // made runnable some other way (e.g. kill()). p->lock must
+  // not be held while taking q->lock.
+  release(&p->lock);
+  acquire(&q->lock);
+  if(p->chan)
+    sleepq_remove(q, p);
+  release(&q->lock);
 
   // Reacquire original lock.
-  if(lk != &p->lock){
-    release(&p->lock);
-    acquire(lk);
-  }
+  acquire(lk);
 }
 
 // Wake up all processes sleeping on chan.
-// Must be called without any p->lock.
+// Must be called without any p->lock, and with the lock
+// that protects the sleepers' condition (the lk they pass
+// to sleep()) held: wakeupn() looks at the bucket without
+// its lock, and that lock is what keeps a sleeper from
+// being half-way into the bucket when it looks.
 void
 wakeup(void *chan)
 {
-  struct proc *p;
+  wakeupn(chan, -1);
+}
 
-  for(p = proc; p < &proc[NPROC]; p++) {
+// Wake up at most n processes sleeping on chan, or all
+// of them if n is negative. Return how many were woken.
+// Must be called without any p->lock.
+int
+wakeupn(void *chan, int n)
+{
+  struct sleepq *q = sleepq_of(chan);
+  struct proc *p, *next;
+  int woken = 0;
+
+  // Sleepers enqueue themselves while holding the lock that
+  // protects their condition, and wakeup() is called with that
+  // lock held, so an empty bucket means nobody is waiting.
+  if(q->head == NULL)
+    return 0;
+
+  acquire(&q->lock);
+  for(p = q->head; p != NULL && woken != n; p = next){
+    next = p->sqnext;
+    if(p->chan != chan)
+      continue;
+    sleepq_remove(q, p);
     acquire(&p->lock);
-    if(p->state == SLEEPING && p->chan == chan) {
-      p->state = RUNNABLE;
+    if(p->state == SLEEPING) {
+      wakeproc(p);
+      woken++;
     }
     release(&p->lock);
   }
+  release(&q->lock);
+  return woken;
+}
+
+// Turn the user address of a futex word into its key: the
+// word's physical address, which is the same for every
+// thread or process that has the page mapped.
+static int *
+futex_key(uint64 uaddr)
+{
+  struct proc *p = myproc();
+  uint64 pa;
+
+  if(uaddr % sizeof(int) != 0 || uaddr + sizeof(int) > p->sz)
+    return NULL;
+  if((pa = walkaddr(p->pagetable, PGROUNDDOWN(uaddr))) == NULL)
+    return NULL;
+  return (int *)(pa + uaddr % PGSIZE);
+}
+
+// Sleep until woken by futexwake(), unless the int at
+// uaddr no longer holds val. Return 0 if we slept,
+// -1 if the value differed or uaddr is bad.
+int
+futexwait(uint64 uaddr, int val)
+{
+  int *key;
+
+  if((key = futex_key(uaddr)) == NULL)
+    return -1;
+  acquire(&futex_lock);
+  if(*(volatile int *)key != val){
+    release(&futex_lock);
+    return -1;
+  }
+  sleep(key, &futex_lock);
+  release(&futex_lock);
+  return 0;
+}
+
+// Wake up at most n waiters on the futex at uaddr.
+// Return how many were woken, or -1 if uaddr is bad.
+int
+futexwake(uint64 uaddr, int n)
+{
+  int *key;
+  int woken;
+
+  if((key = futex_key(uaddr)) == NULL)
+    return -1;
+  acquire(&futex_lock);
+  woken = wakeupn(key, n);
+  release(&futex_lock);
+  return woken;
 }
 
 // Wake up p if it is sleeping in wait(); used by exit().
@@ -692,7 +1125,7 @@ wakeup1(struct proc *p)
   if(!holding(&p->lock))
     panic("wakeup1");
   if(p->chan == p && p->state == SLEEPING) {
-    p->state = RUNNABLE;
+    wakeproc(p);
   }
 }
 
@@ -710,7 +1143,7 @@ kill(int pid)
       p->killed = 1;
       if(p->state == SLEEPING){
         // Wake process from sleep().
-        p->state = RUNNABLE;
+        wakeproc(p);
       }
       release(&p->lock);
       return 0;
@@ -720,6 +1153,98 @@ kill(int pid)
   return -1;
 }
 
+// Set the nice value of the process with the given pid,
+// or of the caller if pid is 0.
+int
+setpriority(int pid, int nice)
+{
+  struct proc *p;
+
+  if(nice < NICE_MIN || nice > NICE_MAX)
+    return -1;
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      p->nice = nice;
+      release(&p->lock);
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Move the process with the given pid, or the caller
+// if pid is 0, into scheduling class policy.
+int
+setscheduler(int pid, int policy)
+{
+  struct proc *p;
+
+  if(policy < 0 || policy >= NSCHEDCLASS)
+    return -1;
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      p->policy = policy;
+      release(&p->lock);
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Restrict the process with the given pid, or the caller
+// if pid is 0, to the harts in mask.
+int
+setaffinity(int pid, uint64 mask)
+{
+  struct proc *p;
+
+  mask &= AFFINITY_ALL;
+  if(mask == 0)
+    return -1;
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      p->affinity = mask;
+      // a hart it may now use could be idle.
+      if(p->state == RUNNABLE)
+        kickidle(p);
+      release(&p->lock);
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+int
+getaffinity(int pid, uint64 *mask)
+{
+  struct proc *p;
+
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      *mask = p->affinity;
+      release(&p->lock);
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
 // Copy to either a user address, or kernel address,
 // depending on usr_dst.
 // Returns 0 on success, -1 on error.
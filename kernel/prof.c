@@ -0,0 +1,117 @@
+// Sampling profiler.
+//
+// While profiling is on, set_next_timeout() fires each hart's
+// timer at least PROF_HZ times a second, and every timer
+// interrupt records where the hart was into that hart's ring.
+// Only the hart itself appends to its ring, with interrupts
+// off; prof(PROF_READ) takes samples off the other end, so
+// neither side needs a spinlock.
+
+#include "include/types.h"
+#include "include/param.h"
+#include "include/riscv.h"
+#include "include/spinlock.h"
+#include "include/sleeplock.h"
+#include "include/proc.h"
+#include "include/vm.h"
+#include "include/string.h"
+#include "include/timer.h"
+#include "include/prof.h"
+
+static struct profring {
+  uint64 head;                  // next slot to fill
+  uint64 tail;                  // next slot to read
+  uint64 dropped;               // samples lost to a full ring
+  struct profsample buf[PROF_NSAMPLE];
+} __attribute__((aligned(64))) rings[NCPU];
+
+static volatile int profiling;
+static struct sleeplock readlock;   // one reader at a time
+
+void
+prof_init(void)
+{
+  initsleeplock(&readlock, "prof");
+}
+
+int
+prof_enabled(void)
+{
+  return profiling;
+}
+
+// Called from devintr() on a timer interrupt, interrupts off.
+void
+prof_sample(void)
+{
+  struct profring *r;
+  struct profsample *s;
+  struct proc *p;
+  uint64 h;
+
+  if(!profiling)
+    return;
+  r = &rings[cpuid()];
+  h = r->head;
+  if(h - *(volatile uint64 *)&r->tail >= PROF_NSAMPLE){
+    r->dropped++;
+    return;
+  }
+  s = &r->buf[h % PROF_NSAMPLE];
+  p = myproc();
+  s->pc = r_sepc();
+  s->user = (r_sstatus() & SSTATUS_SPP) == 0;
+  s->cpu = cpuid();
+  s->pid = p ? p->pid : 0;
+  safestrcpy(s->name, p ? p->name : "idle", PROF_NAME);
+  __sync_synchronize();
+  r->head = h + 1;
+}
+
+int
+prof_ctl(int op, uint64 addr, int n)
+{
+  struct profring *r;
+  uint64 dropped = 0;
+  int i = 0;
+
+  switch(op){
+  case PROF_START:
+    acquiresleep(&readlock);
+    for(r = rings; r < rings + NCPU; r++){
+      r->tail = r->head;
+      r->dropped = 0;
+    }
+    releasesleep(&readlock);
+    __sync_synchronize();
+    profiling = 1;
+    set_next_timeout();   // this hart; the other joins at its next interrupt
+    return 0;
+
+  case PROF_STOP:
+    profiling = 0;
+    for(r = rings; r < rings + NCPU; r++)
+      dropped += r->dropped;
+    return dropped;
+
+  case PROF_READ:
+    acquiresleep(&readlock);
+    for(r = rings; r < rings + NCPU; r++){
+      while(i < n && r->tail != *(volatile uint64 *)&r->head){
+        __sync_synchronize();
+        if(copyout2(addr + i * sizeof(struct profsample),
+                    (char *)&r->buf[r->tail % PROF_NSAMPLE],
+                    sizeof(struct profsample)) < 0){
+          releasesleep(&readlock);
+          return -1;
+        }
+        __sync_synchronize();
+        r->tail++;
+        i++;
+      }
+    }
+    releasesleep(&readlock);
+    return i;
+  }
+  return -1;
+}
@@ -8,6 +8,12 @@
 #include "include/spinlock.h"
 #include "include/proc.h"
 #include "include/sleeplock.h"
+#include "include/printf.h"
+
+// How long a waiter may spin while the holder is running on
+// another hart before it gives up and sleeps: a small fraction
+// of a quantum, well under the cost of two context switches.
+#define SPINTIME    (INTERVAL / 256)
 
 void
 initsleeplock(struct sleeplock *lk, char *name)
@@ -16,17 +22,51 @@ initsleeplock(struct sleeplock *lk, char *name)
   lk->name = name;
   lk->locked = 0;
   lk->pid = 0;
+  lk->owner = 0;
+  lk->waiters = 0;
+}
+
+// Called with lk held and the lock owned by someone else.
+// If the owner is running, drop lk and spin until it lets go,
+// stops running or SPINTIME passes. Returns with lk held; the
+// caller must recheck the lock either way.
+// Returns 1 if it spun, 0 if the caller should sleep instead.
+static int
+spinonowner(struct spinlock *lk, struct proc *volatile *ownerp)
+{
+  struct proc *owner = *ownerp;
+  volatile enum procstate *state;
+  uint64 deadline;
+
+  if(owner == 0 || owner == myproc())
+    return 0;
+  state = &owner->state;
+  if(*state != RUNNING)
+    return 0;
+  release(lk);
+  deadline = r_time() + SPINTIME;
+  while(*ownerp == owner && *state == RUNNING && r_time() < deadline)
+    ;
+  acquire(lk);
+  return 1;
 }
 
 void
 acquiresleep(struct sleeplock *lk)
 {
+  int spun = 0;
+
   acquire(&lk->lk);
   while (lk->locked) {
+    if(!spun && (spun = spinonowner(&lk->lk, &lk->owner)))
+      continue;
+    lk->waiters++;
     sleep(lk, &lk->lk);
+    lk->waiters--;
   }
   lk->locked = 1;
   lk->pid = myproc()->pid;
+  lk->owner = myproc();
   release(&lk->lk);
 }
 
@@ -36,7 +76,11 @@ releasesleep(struct sleeplock *lk)
   acquire(&lk->lk);
   lk->locked = 0;
   lk->pid = 0;
-  wakeup(lk);
+  lk->owner = 0;
+  // Each release hands off to one sleeper; one that loses the
+  // race to a spinner just sleeps again and waits for the next.
+  if(lk->waiters)
+    wakeupn(lk, 1);
   release(&lk->lk);
 }
 
@@ -50,3 +94,85 @@ holdingsleep(struct sleeplock *lk)
   release(&lk->lk);
   return r;
 }
+
+void
+initrwsleeplock(struct rwsleeplock *lk, char *name)
+{
+  initlock(&lk->lk, "rw sleep lock");
+  lk->name = name;
+  lk->readers = 0;
+  lk->writer = 0;
+  lk->rwaiting = 0;
+  lk->wwaiting = 0;
+}
+
+// Shared hold. New readers queue behind waiting writers so a
+// steady stream of readers cannot starve them.
+void
+acquireread(struct rwsleeplock *lk)
+{
+  int spun = 0;
+
+  acquire(&lk->lk);
+  while(lk->writer || lk->wwaiting){
+    if(!spun && (spun = spinonowner(&lk->lk, &lk->writer)))
+      continue;
+    lk->rwaiting++;
+    sleep(&lk->readers, &lk->lk);
+    lk->rwaiting--;
+  }
+  lk->readers++;
+  release(&lk->lk);
+}
+
+void
+releaseread(struct rwsleeplock *lk)
+{
+  acquire(&lk->lk);
+  if(lk->readers <= 0)
+    panic("releaseread");
+  if(--lk->readers == 0 && lk->wwaiting)
+    wakeupn(&lk->writer, 1);
+  release(&lk->lk);
+}
+
+void
+acquirewrite(struct rwsleeplock *lk)
+{
+  int spun = 0;
+
+  acquire(&lk->lk);
+  while(lk->writer || lk->readers){
+    if(!spun && !lk->readers && (spun = spinonowner(&lk->lk, &lk->writer)))
+      continue;
+    lk->wwaiting++;
+    sleep(&lk->writer, &lk->lk);
+    lk->wwaiting--;
+  }
+  lk->writer = myproc();
+  release(&lk->lk);
+}
+
+// Waiting writers go first; readers are let in once none remain.
+void
+releasewrite(struct rwsleeplock *lk)
+{
+  acquire(&lk->lk);
+  lk->writer = 0;
+  if(lk->wwaiting)
+    wakeupn(&lk->writer, 1);
+  else if(lk->rwaiting)
+    wakeup(&lk->readers);
+  release(&lk->lk);
+}
+
+int
+holdingwrite(struct rwsleeplock *lk)
+{
+  int r;
+
+  acquire(&lk->lk);
+  r = lk->writer == myproc();
+  release(&lk->lk);
+  return r;
+}
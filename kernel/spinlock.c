@@ -9,30 +9,104 @@
 #include "include/proc.h"
 #include "include/intr.h"
 #include "include/printf.h"
+#include "include/string.h"
+#include "include/lockstat.h"
+
+#define NLOCKCLASS  48
+
+// Lock classes, one per lock name. Classes are claimed with a
+// compare-and-swap on name, so initlock() needs no lock of its
+// own.
+struct lockclass {
+  char *name;
+  uint64 nlocks;
+};
+
+// Each hart's contention counters, one per class. acquire()
+// only bumps its own hart's, with interrupts off, so they need
+// no atomics and do not bounce between the harts' caches;
+// lockstat_get() adds them up.
+struct lockcount {
+  uint64 nacquire;
+  uint64 ncontended;
+  uint64 nspin;
+  uint64 spintime;
+  uint64 maxhold;
+};
+
+static struct lockclass lockclasses[NLOCKCLASS];
+static struct lockcount lockcounts[NCPU][NLOCKCLASS] __attribute__((aligned(64)));
+
+static struct lockclass *
+lockclass(char *name)
+{
+  struct lockclass *c;
+
+  // Locks are nearly always named by the same string literal,
+  // so try its address before comparing names.
+  for(c = lockclasses; c < lockclasses + NLOCKCLASS && c->name; c++)
+    if(c->name == name)
+      return c;
+  for(c = lockclasses; c < lockclasses + NLOCKCLASS; c++){
+    if(c->name == 0 && __sync_bool_compare_and_swap(&c->name, 0, name))
+      return c;
+    if(c->name == name || strncmp(c->name, name, LOCKSTAT_NAME) == 0)
+      return c;
+  }
+  return 0;     // out of classes; go uncounted
+}
+
+static inline struct lockcount *
+lockcount(struct spinlock *lk)
+{
+  return &lockcounts[cpuid()][lk->class - lockclasses];
+}
 
 void
 initlock(struct spinlock *lk, char *name)
 {
   lk->name = name;
-  lk->locked = 0;
+  lk->next = 0;
+  lk->owner = 0;
   lk->cpu = 0;
+  if((lk->class = lockclass(name)) != 0)
+    __sync_fetch_and_add(&lk->class->nlocks, 1);
+}
+
+// lk is going away, e.g. with the pipe it is in.
+void
+freelock(struct spinlock *lk)
+{
+  if(lk->class)
+    __sync_fetch_and_sub(&lk->class->nlocks, 1);
 }
 
 // Acquire the lock.
-// Loops (spins) until the lock is acquired.
+// Takes a ticket and loops (spins) until it is served.
 void
 acquire(struct spinlock *lk)
 {
+  uint ticket;
+  uint64 nspin = 0;
+#ifdef LOCKSTAT
+  uint64 t0 = 0;
+#endif
+
   push_off(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
 
-  // On RISC-V, sync_lock_test_and_set turns into an atomic swap:
-  //   a5 = 1
-  //   s1 = &lk->locked
-  //   amoswap.w.aq a5, a5, (s1)
-  while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
-    ;
+  // On RISC-V, sync_fetch_and_add turns into an atomic add:
+  //   amoadd.w a5, a4, (s1)
+  ticket = __sync_fetch_and_add(&lk->next, 1);
+  if(*(volatile uint *)&lk->owner != ticket){
+#ifdef LOCKSTAT
+    t0 = r_time();
+#endif
+    do
+      nspin++;
+    while(*(volatile uint *)&lk->owner != ticket);
+  }
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
@@ -42,6 +116,21 @@ acquire(struct spinlock *lk)
 
   // Record info about lock acquisition for holding() and debugging.
   lk->cpu = mycpu();
+
+  if(lk->class){
+    struct lockcount *c = lockcount(lk);
+    c->nacquire++;
+    if(nspin > 0){
+      c->ncontended++;
+      c->nspin += nspin;
+#ifdef LOCKSTAT
+      c->spintime += r_time() - t0;
+#endif
+    }
+  }
+#ifdef LOCKSTAT
+  lk->tacquire = r_time();
+#endif
 }
 
 // Release the lock.
@@ -51,6 +140,15 @@ release(struct spinlock *lk)
   if(!holding(lk))
     panic("release");
 
+#ifdef LOCKSTAT
+  if(lk->class){
+    struct lockcount *c = lockcount(lk);
+    uint64 hold = r_time() - lk->tacquire;
+    if(hold > c->maxhold)
+      c->maxhold = hold;
+  }
+#endif
+
   lk->cpu = 0;
 
   // Tell the C compiler and the CPU to not move loads or stores
@@ -61,14 +159,11 @@ release(struct spinlock *lk)
   // On RISC-V, this emits a fence instruction.
   __sync_synchronize();
 
-  // Release the lock, equivalent to lk->locked = 0.
-  // This code doesn't use a C assignment, since the C standard
-  // implies that an assignment might be implemented with
-  // multiple store instructions.
-  // On RISC-V, sync_lock_release turns into an atomic swap:
-  //   s1 = &lk->locked
-  //   amoswap.w zero, zero, (s1)
-  __sync_lock_release(&lk->locked);
+  // Serve the next ticket, equivalent to lk->owner++.
+  // Only the holder writes owner, but this code doesn't use a C
+  // assignment, since the C standard implies that an assignment
+  // might be implemented with multiple store instructions.
+  __sync_fetch_and_add(&lk->owner, 1);
 
   pop_off();
 }
@@ -79,6 +174,38 @@ int
 holding(struct spinlock *lk)
 {
   int r;
-  r = (lk->locked && lk->cpu == mycpu());
+  r = (lk->owner != lk->next && lk->cpu == mycpu());
   return r;
 }
+
+int
+lockstat_get(int i, struct lockstat *st)
+{
+  struct lockclass *c;
+  struct lockcount *n;
+
+  if(i < 0 || i >= NLOCKCLASS || (c = &lockclasses[i])->name == 0)
+    return 0;
+  safestrcpy(st->name, c->name, LOCKSTAT_NAME);
+  st->nlocks = c->nlocks;
+  st->nacquire = st->ncontended = st->nspin = 0;
+  st->spintime = st->maxhold = 0;
+  for(int cpu = 0; cpu < NCPU; cpu++){
+    n = &lockcounts[cpu][i];
+    st->nacquire += n->nacquire;
+    st->ncontended += n->ncontended;
+    st->nspin += n->nspin;
+    st->spintime += n->spintime;
+    if(n->maxhold > st->maxhold)
+      st->maxhold = n->maxhold;
+  }
+  return 1;
+}
+
+// Other harts' counters may be mid-update; a count that
+// survives the reset is only a small error.
+void
+lockstat_reset(void)
+{
+  memset(lockcounts, 0, sizeof(lockcounts));
+}
@@ -1,13 +1,49 @@
 #include "include/types.h"
+#include "include/riscv.h"
+
+// The word-wide loops below only touch memory 8 bytes at a
+// time when every pointer involved is 8-byte aligned: k210
+// traps misaligned accesses to the SBI, which emulates them
+// very slowly.
+
+#define WSIZE     sizeof(uint64)
+#define WMASK     (WSIZE - 1)
+#define PGALIGNED(p, q) ((((uint64)(p) | (uint64)(q)) & (PGSIZE - 1)) == 0)
 
 void*
 memset(void *dst, int c, uint n)
 {
   char *cdst = (char *) dst;
-  int i;
-  for(i = 0; i < n; i++){
-    cdst[i] = c;
+  uint64 *wdst, w;
+
+  if(n >= 2 * WSIZE){
+    w = (uchar)c;
+    w |= w << 8;
+    w |= w << 16;
+    w |= w << 32;
+    while(((uint64)cdst & WMASK) != 0){
+      *cdst++ = c;
+      n--;
+    }
+    wdst = (uint64 *)cdst;
+    if(n == PGSIZE && PGALIGNED(wdst, 0)){
+      // whole page: the common case for kalloc() and page tables.
+      for(int i = 0; i < PGSIZE / WSIZE; i += 8){
+        wdst[i] = w; wdst[i+1] = w; wdst[i+2] = w; wdst[i+3] = w;
+        wdst[i+4] = w; wdst[i+5] = w; wdst[i+6] = w; wdst[i+7] = w;
+      }
+      return dst;
+    }
+    for(; n >= 8 * WSIZE; n -= 8 * WSIZE, wdst += 8){
+      wdst[0] = w; wdst[1] = w; wdst[2] = w; wdst[3] = w;
+      wdst[4] = w; wdst[5] = w; wdst[6] = w; wdst[7] = w;
+    }
+    for(; n >= WSIZE; n -= WSIZE)
+      *wdst++ = w;
+    cdst = (char *)wdst;
   }
+  while(n-- > 0)
+    *cdst++ = c;
   return dst;
 }
 
@@ -18,6 +54,17 @@ memcmp(const void *v1, const void *v2, uint n)
 
   s1 = v1;
   s2 = v2;
+  if(((uint64)s1 & WMASK) == ((uint64)s2 & WMASK)){
+    while(n > 0 && ((uint64)s1 & WMASK) != 0){
+      if(*s1 != *s2)
+        return *s1 - *s2;
+      s1++, s2++, n--;
+    }
+    // skip equal words; the bytes loop finds the difference.
+    while(n >= WSIZE && *(uint64 *)s1 == *(uint64 *)s2){
+      s1 += WSIZE, s2 += WSIZE, n -= WSIZE;
+    }
+  }
   while(n-- > 0){
     if(*s1 != *s2)
       return *s1 - *s2;
@@ -32,17 +79,58 @@ memmove(void *dst, const void *src, uint n)
 {
   const char *s;
   char *d;
+  const uint64 *ws;
+  uint64 *wd;
 
   s = src;
   d = dst;
   if(s < d && s + n > d){
+    // overlapping, with dst above src: copy backwards.
     s += n;
     d += n;
+    if(((uint64)s & WMASK) == ((uint64)d & WMASK)){
+      while(n > 0 && ((uint64)d & WMASK) != 0){
+        *--d = *--s;
+        n--;
+      }
+      ws = (const uint64 *)s;
+      wd = (uint64 *)d;
+      for(; n >= WSIZE; n -= WSIZE)
+        *--wd = *--ws;
+      s = (const char *)ws;
+      d = (char *)wd;
+    }
     while(n-- > 0)
       *--d = *--s;
-  } else
-    while(n-- > 0)
+    return dst;
+  }
+
+  if(((uint64)s & WMASK) == ((uint64)d & WMASK)){
+    while(n > 0 && ((uint64)d & WMASK) != 0){
       *d++ = *s++;
+      n--;
+    }
+    ws = (const uint64 *)s;
+    wd = (uint64 *)d;
+    if(n == PGSIZE && PGALIGNED(ws, wd)){
+      // whole page, as in uvmcopy() and exec().
+      for(int i = 0; i < PGSIZE / WSIZE; i += 8){
+        wd[i] = ws[i]; wd[i+1] = ws[i+1]; wd[i+2] = ws[i+2]; wd[i+3] = ws[i+3];
+        wd[i+4] = ws[i+4]; wd[i+5] = ws[i+5]; wd[i+6] = ws[i+6]; wd[i+7] = ws[i+7];
+      }
+      return dst;
+    }
+    for(; n >= 8 * WSIZE; n -= 8 * WSIZE, ws += 8, wd += 8){
+      wd[0] = ws[0]; wd[1] = ws[1]; wd[2] = ws[2]; wd[3] = ws[3];
+      wd[4] = ws[4]; wd[5] = ws[5]; wd[6] = ws[6]; wd[7] = ws[7];
+    }
+    for(; n >= WSIZE; n -= WSIZE)
+      *wd++ = *ws++;
+    s = (const char *)ws;
+    d = (char *)wd;
+  }
+  while(n-- > 0)
+    *d++ = *s++;
 
   return dst;
 }
@@ -140,4 +228,123 @@ strchr(const char *s, char c)
     if(*s == c)
       return (char*)s;
   return 0;
-}
\ No newline at end of file
+}
+#ifdef DEBUG
+
+#include "include/kalloc.h"
+#include "include/printf.h"
+
+// The original byte-at-a-time versions, kept as a reference
+// for string_selftest().
+
+static void*
+bmemset(void *dst, int c, uint n)
+{
+  char *cdst = (char *) dst;
+  for(uint i = 0; i < n; i++)
+    cdst[i] = c;
+  return dst;
+}
+
+static int
+bmemcmp(const void *v1, const void *v2, uint n)
+{
+  const uchar *s1 = v1, *s2 = v2;
+  while(n-- > 0){
+    if(*s1 != *s2)
+      return *s1 - *s2;
+    s1++, s2++;
+  }
+  return 0;
+}
+
+static void*
+bmemmove(void *dst, const void *src, uint n)
+{
+  const char *s = src;
+  char *d = dst;
+  if(s < d && s + n > d){
+    s += n;
+    d += n;
+    while(n-- > 0)
+      *--d = *--s;
+  } else
+    while(n-- > 0)
+      *d++ = *s++;
+  return dst;
+}
+
+static int
+sign(int x)
+{
+  return (x > 0) - (x < 0);
+}
+
+// Check the word-wide routines against the byte loops at every
+// alignment and a spread of lengths, then time both on whole pages.
+void
+string_selftest(void)
+{
+  char *a = kalloc(), *b = kalloc(), *c = kalloc();
+  uint64 t0, t[6];
+  volatile int sink;
+  int i, off, soff, n;
+  static const int lens[] = { 0, 1, 7, 8, 9, 15, 16, 17, 63, 64, 65, 200, 1000 };
+
+  if(a == 0 || b == 0 || c == 0)
+    panic("string_selftest: kalloc");
+
+  for(off = 0; off < 8; off++){
+    for(soff = 0; soff < 8; soff++){
+      for(i = 0; i < sizeof(lens) / sizeof(lens[0]); i++){
+        n = lens[i];
+        for(int j = 0; j < PGSIZE; j++)
+          a[j] = b[j] = j * 7 + 3;
+        memset(a + off, off + 1, n);
+        bmemset(b + off, off + 1, n);
+        if(bmemcmp(a, b, PGSIZE) != 0)
+          panic("string_selftest: memset");
+        memmove(a + off, a + soff + 512, n);
+        bmemmove(b + off, b + soff + 512, n);
+        memmove(a + off + 16, a + soff, n);
+        bmemmove(b + off + 16, b + soff, n);
+        memmove(a + soff, a + off + 16, n);
+        bmemmove(b + soff, b + off + 16, n);
+        if(bmemcmp(a, b, PGSIZE) != 0)
+          panic("string_selftest: memmove");
+        if(n > 0)
+          b[soff + n - 1]++;
+        if(sign(memcmp(a + soff, b + soff, n)) != sign(bmemcmp(a + soff, b + soff, n)) ||
+           sign(memcmp(a + off, b + soff, n)) != sign(bmemcmp(a + off, b + soff, n)))
+          panic("string_selftest: memcmp");
+      }
+    }
+  }
+
+  #define SELFTEST_ROUNDS 256
+  t0 = r_time();
+  for(i = 0; i < SELFTEST_ROUNDS; i++) bmemset(a, i, PGSIZE);
+  t[0] = r_time() - t0, t0 = r_time();
+  for(i = 0; i < SELFTEST_ROUNDS; i++) memset(a, i, PGSIZE);
+  t[1] = r_time() - t0, t0 = r_time();
+  for(i = 0; i < SELFTEST_ROUNDS; i++) bmemmove(b, a, PGSIZE);
+  t[2] = r_time() - t0, t0 = r_time();
+  for(i = 0; i < SELFTEST_ROUNDS; i++) memmove(c, a, PGSIZE);
+  t[3] = r_time() - t0, t0 = r_time();
+  for(i = 0; i < SELFTEST_ROUNDS; i++) sink = bmemcmp(b, c, PGSIZE);
+  t[4] = r_time() - t0, t0 = r_time();
+  for(i = 0; i < SELFTEST_ROUNDS; i++) sink = memcmp(b, c, PGSIZE);
+  t[5] = r_time() - t0;
+  (void)sink;
+
+  printf("string_selftest: %d x 4K pages, old/new ticks\n", SELFTEST_ROUNDS);
+  printf("  memset  %d / %d\n", (int)t[0], (int)t[1]);
+  printf("  memmove %d / %d\n", (int)t[2], (int)t[3]);
+  printf("  memcmp  %d / %d\n", (int)t[4], (int)t[5]);
+
+  kfree(a);
+  kfree(b);
+  kfree(c);
+}
+
+#endif
@@ -7,10 +7,15 @@
 #include "include/proc.h"
 #include "include/syscall.h"
 #include "include/sysinfo.h"
+#include "include/lockstat.h"
 #include "include/kalloc.h"
 #include "include/vm.h"
 #include "include/string.h"
 #include "include/printf.h"
+#include "include/cpustat.h"
+#include "include/latency.h"
+#include "include/trace.h"
+#include "include/timer.h"
 
 // Fetch the uint64 at addr from the current process.
 int
@@ -116,6 +121,24 @@ extern uint64 sys_remove(void);
 extern uint64 sys_trace(void);
 extern uint64 sys_sysinfo(void);
 extern uint64 sys_rename(void);
+extern uint64 sys_nanosleep(void);
+extern uint64 sys_setpriority(void);
+extern uint64 sys_setscheduler(void);
+extern uint64 sys_sched_setaffinity(void);
+extern uint64 sys_sched_getaffinity(void);
+extern uint64 sys_clone(void);
+extern uint64 sys_futex(void);
+extern uint64 sys_fcntl(void);
+extern uint64 sys_splice(void);
+extern uint64 sys_tee(void);
+extern uint64 sys_lockstat(void);
+extern uint64 sys_cpustat(void);
+extern uint64 sys_traceread(void);
+extern uint64 sys_prof(void);
+extern uint64 sys_latency(void);
+extern uint64 sys_lseek(void);
+extern uint64 sys_rdtime(void);
+extern uint64 sys_sched_yield(void);
 
 static uint64 (*syscalls[])(void) = {
   [SYS_fork]        sys_fork,
@@ -144,35 +167,24 @@ static uint64 (*syscalls[])(void) = {
   [SYS_trace]       sys_trace,
   [SYS_sysinfo]     sys_sysinfo,
   [SYS_rename]      sys_rename,
-};
-
-static char *sysnames[] = {
-  [SYS_fork]        "fork",
-  [SYS_exit]        "exit",
-  [SYS_wait]        "wait",
-  [SYS_pipe]        "pipe",
-  [SYS_read]        "read",
-  [SYS_kill]        "kill",
-  [SYS_exec]        "exec",
-  [SYS_fstat]       "fstat",
-  [SYS_chdir]       "chdir",
-  [SYS_dup]         "dup",
-  [SYS_getpid]      "getpid",
-  [SYS_sbrk]        "sbrk",
-  [SYS_sleep]       "sleep",
-  [SYS_uptime]      "uptime",
-  [SYS_open]        "open",
-  [SYS_write]       "write",
-  [SYS_mkdir]       "mkdir",
-  [SYS_close]       "close",
-  [SYS_test_proc]   "test_proc",
-  [SYS_dev]         "dev",
-  [SYS_readdir]     "readdir",
-  [SYS_getcwd]      "getcwd",
-  [SYS_remove]      "remove",
-  [SYS_trace]       "trace",
-  [SYS_sysinfo]     "sysinfo",
-  [SYS_rename]      "rename",
+  [SYS_nanosleep]   sys_nanosleep,
+  [SYS_setpriority] sys_setpriority,
+  [SYS_setscheduler] sys_setscheduler,
+  [SYS_sched_setaffinity] sys_sched_setaffinity,
+  [SYS_sched_getaffinity] sys_sched_getaffinity,
+  [SYS_clone]       sys_clone,
+  [SYS_futex]       sys_futex,
+  [SYS_fcntl]       sys_fcntl,
+  [SYS_splice]      sys_splice,
+  [SYS_tee]         sys_tee,
+  [SYS_lockstat]    sys_lockstat,
+  [SYS_cpustat]     sys_cpustat,
+  [SYS_traceread]   sys_traceread,
+  [SYS_prof]        sys_prof,
+  [SYS_latency]     sys_latency,
+  [SYS_lseek]       sys_lseek,
+  [SYS_rdtime]      sys_rdtime,
+  [SYS_sched_yield] sys_sched_yield,
 };
 
 void
@@ -180,13 +192,30 @@ syscall(void)
 {
   int num;
   struct proc *p = myproc();
+  uint64 t0 = lat_begin(), t;
 
   num = p->trapframe->a7;
+  CPUSTAT_INC(syscall);
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
-    p->trapframe->a0 = syscalls[num]();
-        // trace
-    if ((p->tmask & (1 << num)) != 0) {
-      printf("pid %d: %s -> %d\n", p->pid, sysnames[num], p->trapframe->a0);
+    if(num < CPUSTAT_NSYSCALL)
+      CPUSTAT_INC(nsyscall[num]);
+    if ((p->tmask & (1UL << num)) != 0) {
+      // trace: a0 is overwritten by the return value, and
+      // exit never returns, so take the arguments first.
+      uint64 args[TRACE_NARG], tt0 = r_time();
+      memmove(args, &p->trapframe->a0, sizeof(args));
+      if (num == SYS_exit)
+        trace_record(num, args, 0, tt0);
+      p->trapframe->a0 = syscalls[num]();
+      trace_record(num, args, p->trapframe->a0, tt0);
+    } else {
+      p->trapframe->a0 = syscalls[num]();
+    }
+    if (t0 != 0) {
+      t = r_time() - t0;
+      lat_add(LAT_SYSCALL, t);
+      if (num < LAT_NSYSCALL)
+        lat_add(LAT_SYS(num), t);
     }
   } else {
     printf("pid %d %s: unknown sys call %d\n",
@@ -216,6 +245,7 @@ sys_sysinfo(void)
   struct sysinfo info;
   info.freemem = freemem_amount();
   info.nproc = procnum();
+  info.boottime = boot_entry;
 
   // if (copyout(p->pagetable, addr, (char *)&info, sizeof(info)) < 0) {
   if (copyout2(addr, (char *)&info, sizeof(info)) < 0) {
@@ -223,4 +253,44 @@ sys_sysinfo(void)
   }
 
   return 0;
-}
\ No newline at end of file
+}
+// Copy out hart cpu's event counters, or their sum over all
+// harts if cpu is -1. Returns the number of harts.
+uint64
+sys_cpustat(void)
+{
+  int cpu;
+  uint64 addr;
+
+  if (argint(0, &cpu) < 0 || argaddr(1, &addr) < 0) {
+    return -1;
+  }
+  if (cpustat_copyout(cpu, addr) < 0) {
+    return -1;
+  }
+  return NCPU;
+}
+
+// Copy up to n lock classes' counters to the array at addr and
+// return how many there were. With addr 0, zero the counters.
+uint64
+sys_lockstat(void)
+{
+  uint64 addr;
+  int n, i;
+  struct lockstat st;
+
+  if (argaddr(0, &addr) < 0 || argint(1, &n) < 0) {
+    return -1;
+  }
+  if (addr == 0) {
+    lockstat_reset();
+    return 0;
+  }
+  for (i = 0; i < n && lockstat_get(i, &st); i++) {
+    if (copyout2(addr + i * sizeof(st), (char *)&st, sizeof(st)) < 0) {
+      return -1;
+    }
+  }
+  return i;
+}
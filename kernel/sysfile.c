@@ -32,7 +32,7 @@ argfd(int n, int *pfd, struct file **pf)
 
   if(argint(n, &fd) < 0)
     return -1;
-  if(fd < 0 || fd >= NOFILE || (f=myproc()->ofile[fd]) == NULL)
+  if(fd < 0 || fd >= NOFILE || (f=myproc()->group->ofile[fd]) == NULL)
     return -1;
   if(pfd)
     *pfd = fd;
@@ -47,14 +47,18 @@ static int
 fdalloc(struct file *f)
 {
   int fd;
-  struct proc *p = myproc();
+  struct proc *g = myproc()->group;
 
+  // Threads of g may be allocating descriptors too.
+  acquire(&g->lock);
   for(fd = 0; fd < NOFILE; fd++){
-    if(p->ofile[fd] == 0){
-      p->ofile[fd] = f;
+    if(g->ofile[fd] == 0){
+      g->ofile[fd] = f;
+      release(&g->lock);
       return fd;
     }
   }
+  release(&g->lock);
   return -1;
 }
 
@@ -103,9 +107,18 @@ sys_close(void)
   int fd;
   struct file *f;
 
+  struct proc *g = myproc()->group;
+
   if(argfd(0, &fd, &f) < 0)
     return -1;
-  myproc()->ofile[fd] = 0;
+  // Another thread may have closed fd since argfd() looked.
+  acquire(&g->lock);
+  if(g->ofile[fd] != f){
+    release(&g->lock);
+    return -1;
+  }
+  g->ofile[fd] = 0;
+  release(&g->lock);
   fileclose(f);
   return 0;
 }
@@ -121,6 +134,70 @@ sys_fstat(void)
   return filestat(f, st);
 }
 
+uint64
+sys_lseek(void)
+{
+  struct file *f;
+  int off, whence;
+
+  if(argfd(0, 0, &f) < 0 || argint(1, &off) < 0 || argint(2, &whence) < 0)
+    return -1;
+  return fileseek(f, off, whence);
+}
+
+// Move data between a pipe and a file, or between two pipes,
+// without copying it through user space.
+uint64
+sys_splice(void)
+{
+  struct file *in, *out;
+  int n;
+
+  if(argfd(0, 0, &in) < 0 || argfd(1, 0, &out) < 0 || argint(2, &n) < 0)
+    return -1;
+  if(!in->readable || !out->writable || n < 0)
+    return -1;
+  if(!(in->type == FD_PIPE && (out->type == FD_PIPE || out->type == FD_ENTRY)) &&
+     !(in->type == FD_ENTRY && out->type == FD_PIPE))
+    return -1;
+  return pipesplice(in, out, n);
+}
+
+// Duplicate data from one pipe into another without consuming it.
+uint64
+sys_tee(void)
+{
+  struct file *in, *out;
+  int n;
+
+  if(argfd(0, 0, &in) < 0 || argfd(1, 0, &out) < 0 || argint(2, &n) < 0)
+    return -1;
+  if(!in->readable || !out->writable || n < 0)
+    return -1;
+  if(in->type != FD_PIPE || out->type != FD_PIPE)
+    return -1;
+  return pipetee(in->pipe, out->pipe, n);
+}
+
+uint64
+sys_fcntl(void)
+{
+  struct file *f;
+  int cmd, arg;
+
+  if(argfd(0, 0, &f) < 0 || argint(1, &cmd) < 0 || argint(2, &arg) < 0)
+    return -1;
+  if(f->type != FD_PIPE)
+    return -1;
+  switch(cmd){
+  case F_SETPIPE_SZ:
+    return pipesetsize(f->pipe, arg);
+  case F_GETPIPE_SZ:
+    return f->pipe->size;
+  }
+  return -1;
+}
+
 static struct dirent*
 create(char *path, short type, int mode)
 {
@@ -243,8 +320,8 @@ sys_chdir(void)
     return -1;
   }
   eunlock(ep);
-  eput(p->cwd);
-  p->cwd = ep;
+  eput(p->group->cwd);
+  p->group->cwd = ep;
   return 0;
 }
 
@@ -263,7 +340,7 @@ sys_pipe(void)
   fd0 = -1;
   if((fd0 = fdalloc(rf)) < 0 || (fd1 = fdalloc(wf)) < 0){
     if(fd0 >= 0)
-      p->ofile[fd0] = 0;
+      p->group->ofile[fd0] = 0;
     fileclose(rf);
     fileclose(wf);
     return -1;
@@ -272,8 +349,8 @@ sys_pipe(void)
   //    copyout(p->pagetable, fdarray+sizeof(fd0), (char *)&fd1, sizeof(fd1)) < 0){
   if(copyout2(fdarray, (char*)&fd0, sizeof(fd0)) < 0 ||
      copyout2(fdarray+sizeof(fd0), (char *)&fd1, sizeof(fd1)) < 0){
-    p->ofile[fd0] = 0;
-    p->ofile[fd1] = 0;
+    p->group->ofile[fd0] = 0;
+    p->group->ofile[fd1] = 0;
     fileclose(rf);
     fileclose(wf);
     return -1;
@@ -336,7 +413,7 @@ sys_getcwd(void)
   if (argaddr(0, &addr) < 0)
     return -1;
 
-  struct dirent *de = myproc()->cwd;
+  struct dirent *de = myproc()->group->cwd;
   char path[FAT32_MAX_PATH];
   char *s;
   int len;
@@ -10,6 +10,11 @@
 #include "include/kalloc.h"
 #include "include/string.h"
 #include "include/printf.h"
+#include "include/intr.h"
+#include "include/futex.h"
+#include "include/trace.h"
+#include "include/prof.h"
+#include "include/latency.h"
 
 extern int exec(char *path, char **argv);
 
@@ -104,21 +109,26 @@ uint64
 sys_sleep(void)
 {
   int n;
-  uint ticks0;
 
   if(argint(0, &n) < 0)
     return -1;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(myproc()->killed){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
+  if(n <= 0)
+    return 0;
+  return timer_sleep_until(r_time() + (uint64)n * INTERVAL);
+}
+
+// sleep for the given number of nanoseconds,
+// with the resolution of the timebase rather than of INTERVAL.
+uint64
+sys_nanosleep(void)
+{
+  uint64 ns;
+
+  if(argaddr(0, &ns) < 0)
+    return -1;
+  uint64 t = ns / 1000000000 * CLK_FREQ
+           + ns % 1000000000 * (CLK_FREQ / 1000000) / 1000;
+  return timer_sleep_until(r_time() + t);
 }
 
 uint64
@@ -136,21 +146,150 @@ sys_kill(void)
 uint64
 sys_uptime(void)
 {
-  uint xticks;
+  return timer_ticks();
+}
+
+// The timebase counter, CLK_FREQ counts a second: a clock
+// fine enough to time single operations from user space.
+uint64
+sys_rdtime(void)
+{
+  return r_time();
+}
+
+uint64
+sys_sched_yield(void)
+{
+  yield();
+  return 0;
+}
+
+uint64
+sys_setpriority(void)
+{
+  int pid, nice;
+
+  if(argint(0, &pid) < 0 || argint(1, &nice) < 0)
+    return -1;
+  return setpriority(pid, nice);
+}
+
+uint64
+sys_setscheduler(void)
+{
+  int pid, policy;
+
+  if(argint(0, &pid) < 0 || argint(1, &policy) < 0)
+    return -1;
+  return setscheduler(pid, policy);
+}
+
+uint64
+sys_sched_setaffinity(void)
+{
+  int pid;
+  uint64 mask;
+
+  if(argint(0, &pid) < 0 || argaddr(1, &mask) < 0)
+    return -1;
+  if(setaffinity(pid, mask) < 0)
+    return -1;
+  // leave this hart now if we are no longer allowed on it.
+  push_off();
+  int allowed = myproc()->affinity & (1UL << cpuid());
+  pop_off();
+  if(!allowed)
+    yield();
+  return 0;
+}
+
+uint64
+sys_sched_getaffinity(void)
+{
+  int pid;
+  uint64 mask;
+
+  if(argint(0, &pid) < 0)
+    return -1;
+  if(getaffinity(pid, &mask) < 0)
+    return -1;
+  return mask;
+}
+
+uint64
+sys_clone(void)
+{
+  uint64 fn, arg, ustack;
+
+  if(argaddr(0, &fn) < 0 || argaddr(1, &arg) < 0 || argaddr(2, &ustack) < 0)
+    return -1;
+  return clone(fn, arg, ustack);
+}
+
+uint64
+sys_futex(void)
+{
+  uint64 uaddr;
+  int op, val;
 
-  acquire(&tickslock);
-  xticks = ticks;
-  release(&tickslock);
-  return xticks;
+  if(argaddr(0, &uaddr) < 0 || argint(1, &op) < 0 || argint(2, &val) < 0)
+    return -1;
+  switch(op){
+  case FUTEX_WAIT:
+    return futexwait(uaddr, val);
+  case FUTEX_WAKE:
+    return futexwake(uaddr, val);
+  }
+  return -1;
 }
 
 uint64
 sys_trace(void)
 {
-  int mask;
-  if(argint(0, &mask) < 0) {
+  uint64 mask;
+  if(argaddr(0, &mask) < 0) {
     return -1;
   }
   myproc()->tmask = mask;
   return 0;
-}
\ No newline at end of file
+}
+
+// Copy up to n trace records of hart cpu, from seq from on,
+// to the struct tracerec array at addr.
+uint64
+sys_traceread(void)
+{
+  int cpu, n;
+  uint64 from, addr;
+
+  if(argint(0, &cpu) < 0 || argaddr(1, &from) < 0 ||
+     argaddr(2, &addr) < 0 || argint(3, &n) < 0)
+    return -1;
+  return trace_read(cpu, from, addr, n);
+}
+
+// prof(op, buf, n): start or stop the sampling profiler,
+// or move up to n samples to the struct profsample array buf.
+uint64
+sys_prof(void)
+{
+  int op, n;
+  uint64 addr;
+
+  if(argint(0, &op) < 0 || argaddr(1, &addr) < 0 || argint(2, &n) < 0)
+    return -1;
+  return prof_ctl(op, addr, n);
+}
+
+// latency(op, id, buf): start or stop timing, or copy
+// histogram id to the struct lathist at buf.
+uint64
+sys_latency(void)
+{
+  int op, id;
+  uint64 addr;
+
+  if(argint(0, &op) < 0 || argint(1, &id) < 0 || argaddr(2, &addr) < 0)
+    return -1;
+  return lat_ctl(op, id, addr);
+}
@@ -1,4 +1,15 @@
 // Timer Interrupt handler
+//
+// The timer is tickless: each hart programs its SBI timer
+// for the earliest of the next pending sleep deadline and,
+// if it is running a process, the end of the current quantum
+// of that process's scheduling class.
+// An idle hart therefore sleeps in wfi until a deadline, a
+// device interrupt, or an IPI from a hart that has made a
+// process runnable (see kickidle() in proc.c), instead of
+// waking every INTERVAL.
+// While the profiler is on, the timer also fires PROF_HZ times
+// a second; those extra interrupts only take a sample.
 
 
 #include "include/types.h"
@@ -9,17 +20,45 @@
 #include "include/timer.h"
 #include "include/printf.h"
 #include "include/proc.h"
+#include "include/intr.h"
+#include "include/prof.h"
 
-struct spinlock tickslock;
-uint ticks;
+// Processes in timed sleep, sorted by p->wakeat.
+static struct {
+  struct spinlock lock;
+  struct proc *head;
+} timers;
+
+uint64 boot_entry;
+static uint64 boot_time;      // r_time() at timerinit()
+static uint64 armed[NCPU];    // next real event on each hart
+static uint64 fire[NCPU];     // what each hart's timer is set for
 
 void timerinit() {
-    initlock(&tickslock, "time");
+    initlock(&timers.lock, "time");
+    timers.head = NULL;
+    boot_time = r_time();
+    for (int i = 0; i < NCPU; i++) {
+        armed[i] = fire[i] = ~0UL;
+    }
     #ifdef DEBUG
     printf("timerinit\n");
     #endif
 }
 
+// Program this hart's timer for next, or for the profiler's
+// next sample if that comes first. Interrupts must be off.
+static void
+arm(uint64 next)
+{
+    if (prof_enabled() && r_time() + CLK_FREQ / PROF_HZ < next) {
+        next = r_time() + CLK_FREQ / PROF_HZ;
+    }
+    fire[cpuid()] = next;
+    sbi_set_timer(next);
+}
+
+// Program this hart's timer for the next event it cares about.
 void
 set_next_timeout() {
     // There is a very strange bug,
@@ -28,13 +67,103 @@ set_next_timeout() {
 
     // this bug seems to disappear automatically
     // printf("");
-    sbi_set_timer(r_time() + INTERVAL);
+    uint64 next = ~0UL;
+    struct proc *p;
+    uint64 wakeat;
+
+    push_off();
+    if (mycpu()->proc != 0) {
+        next = r_time() + sched_quantum(mycpu()->proc);
+    }
+    // Peek at the earliest deadline without timers.lock, since
+    // scheduler() calls us holding a p->lock. A stale value only
+    // costs an early interrupt: whoever inserts or pops a deadline
+    // re-arms its own hart afterwards.
+    if ((p = timers.head) != NULL && (wakeat = p->wakeat) != 0 && wakeat < next) {
+        next = wakeat;
+    }
+    armed[cpuid()] = next;
+    arm(next);
+    pop_off();
+}
+
+// Returns 1 if a deadline or the end of a quantum was due,
+// 0 if the interrupt was only for the profiler.
+int timer_tick() {
+    struct proc *p;
+    uint64 now = r_time(), wakeat;
+    int due = now >= armed[cpuid()];
+
+    acquire(&timers.lock);
+    while ((p = timers.head) != NULL && p->wakeat <= now) {
+        timers.head = p->tmnext;
+        p->tmnext = NULL;
+        p->wakeat = 0;
+        wakeup(&p->wakeat);
+    }
+    release(&timers.lock);
+    if (due) {
+        set_next_timeout();
+        return 1;
+    }
+    // Only the profiler's tick: the quantum still ends at
+    // armed[], so do not start it over. A deadline another hart
+    // inserted may now be the earliest, though.
+    if ((p = timers.head) != NULL && (wakeat = p->wakeat) != 0 && wakeat < armed[cpuid()]) {
+        armed[cpuid()] = wakeat;
+    }
+    arm(armed[cpuid()]);
+    return 0;
 }
 
-void timer_tick() {
-    acquire(&tickslock);
-    ticks++;
-    wakeup(&ticks);
-    release(&tickslock);
-    set_next_timeout();
+// Number of INTERVALs since boot, as reported by uptime().
+uint64
+timer_ticks(void)
+{
+    return (r_time() - boot_time) / INTERVAL;
+}
+
+// Sleep until r_time() reaches deadline.
+// Return 0 on timeout, or -1 if killed first.
+int
+timer_sleep_until(uint64 deadline)
+{
+    struct proc *p = myproc();
+    struct proc **pp;
+
+    if (deadline <= r_time()) {
+        return 0;
+    }
+
+    acquire(&timers.lock);
+    p->wakeat = deadline;
+    for (pp = &timers.head; *pp != NULL && (*pp)->wakeat <= deadline; pp = &(*pp)->tmnext)
+        ;
+    p->tmnext = *pp;
+    *pp = p;
+
+    // Nobody else may be looking at this deadline yet,
+    // so make sure at least this hart fires for it.
+    if (deadline < armed[cpuid()]) {
+        armed[cpuid()] = deadline;
+    }
+    if (deadline < fire[cpuid()]) {
+        fire[cpuid()] = deadline;
+        sbi_set_timer(deadline);
+    }
+
+    while (p->wakeat != 0) {
+        if (p->killed) {
+            for (pp = &timers.head; *pp != p; pp = &(*pp)->tmnext)
+                ;
+            *pp = p->tmnext;
+            p->tmnext = NULL;
+            p->wakeat = 0;
+            release(&timers.lock);
+            return -1;
+        }
+        sleep(&p->wakeat, &timers.lock);
+    }
+    release(&timers.lock);
+    return 0;
 }
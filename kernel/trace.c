@@ -0,0 +1,84 @@
+// Binary system call trace: a ring of records per hart.
+//
+// Only a hart's own syscall() writes its ring, with interrupts
+// off, so writers need no lock. Readers on either hart copy
+// records out seqlock-style: a record's seq is cleared while it
+// is being rewritten, and a copy only counts if seq was the
+// expected value both before and after.
+
+#include "include/types.h"
+#include "include/param.h"
+#include "include/riscv.h"
+#include "include/spinlock.h"
+#include "include/proc.h"
+#include "include/intr.h"
+#include "include/vm.h"
+#include "include/string.h"
+#include "include/sysnum.h"
+#include "include/trace.h"
+
+#define SEQ_BUSY  (~0UL)
+
+static struct tracering {
+  uint64 head;                      // seq of the next record
+  struct tracerec rec[TRACE_NREC];
+} __attribute__((aligned(64))) rings[NCPU];
+
+void
+trace_record(int num, uint64 *args, uint64 ret, uint64 tenter)
+{
+  struct tracering *ring;
+  struct tracerec *r;
+  uint64 seq;
+
+  push_off();
+  ring = &rings[cpuid()];
+  seq = ring->head;
+  r = &ring->rec[seq % TRACE_NREC];
+  r->seq = SEQ_BUSY;
+  __sync_synchronize();
+  r->tenter = tenter;
+  r->texit = num == SYS_exit ? tenter : r_time();
+  memmove(r->args, args, sizeof(r->args));
+  r->ret = ret;
+  r->pid = myproc()->pid;
+  r->num = num;
+  r->cpu = cpuid();
+  __sync_synchronize();
+  r->seq = seq;
+  ring->head = seq + 1;
+  pop_off();
+}
+
+// Copy up to n records of hart cpu's ring, oldest first from
+// seq from on, to the user array at addr. Records already
+// overwritten are skipped. Returns the number copied.
+int
+trace_read(int cpu, uint64 from, uint64 addr, int n)
+{
+  struct tracering *ring;
+  struct tracerec rec;
+  uint64 seq, head;
+  int i;
+
+  if(cpu < 0 || cpu >= NCPU || n < 0)
+    return -1;
+  ring = &rings[cpu];
+  head = *(volatile uint64 *)&ring->head;
+  if(head > TRACE_NREC && from < head - TRACE_NREC)
+    from = head - TRACE_NREC;
+  for(i = 0, seq = from; i < n && seq < head; seq++){
+    struct tracerec *r = &ring->rec[seq % TRACE_NREC];
+    if(*(volatile uint64 *)&r->seq != seq)
+      continue;
+    __sync_synchronize();
+    rec = *r;
+    __sync_synchronize();
+    if(*(volatile uint64 *)&r->seq != seq)
+      continue;               // overwritten while we copied it
+    if(copyout2(addr + i * sizeof(rec), (char *)&rec, sizeof(rec)) < 0)
+      return -1;
+    i++;
+  }
+  return i;
+}
@@ -10,8 +10,12 @@
 #include "include/syscall.h"
 #include "include/printf.h"
 #include "include/console.h"
+#include "include/uart.h"
 #include "include/timer.h"
 #include "include/disk.h"
+#include "include/cpustat.h"
+#include "include/prof.h"
+#include "include/latency.h"
 
 extern char trampoline[], uservec[], userret[];
 
@@ -81,6 +85,9 @@ usertrap(void)
     // ok
   } 
   else {
+    uint64 cause = r_scause();
+    if(cause == 12 || cause == 13 || cause == 15)
+      CPUSTAT_INC(pgfault);
     printf("\nusertrap(): unexpected scause %p pid=%d %s\n", r_scause(), p->pid, p->name);
     printf("            sepc=%p stval=%p\n", r_sepc(), r_stval());
     // trapframedump(p->trapframe);
@@ -140,7 +147,7 @@ usertrapret(void)
   // switches to the user page table, restores user registers,
   // and switches to user mode with sret.
   uint64 fn = TRAMPOLINE + (userret - trampoline);
-  ((void (*)(uint64,uint64))fn)(TRAPFRAME, satp);
+  ((void (*)(uint64,uint64))fn)(p->utrapframe, satp);
 }
 
 // interrupts and exceptions from kernel code go here via kernelvec,
@@ -180,11 +187,13 @@ kerneltrap() {
 
 // Check if it's an external/software interrupt, 
 // and handle it. 
-// returns  2 if timer interrupt, 
-//          1 if other device, 
+// returns  2 if timer interrupt (time to yield), 
+//          1 if other device, or a profiling-only tick, 
 //          0 if not recognized. 
 int devintr(void) {
 	uint64 scause = r_scause();
+	uint64 t0 = lat_begin();
+	int which;
 
 	#ifdef QEMU 
 	// handle external interrupt 
@@ -197,12 +206,14 @@ int devintr(void) {
 	#endif 
 	{
 		int irq = plic_claim();
+		if (irq > 0) {
+			CPUSTAT_INC(intr);
+			if (irq < CPUSTAT_NIRQ)
+				CPUSTAT_INC(nirq[irq]);
+		}
 		if (UART_IRQ == irq) {
-			// keyboard input 
-			int c = sbi_console_getchar();
-			if (-1 != c) {
-				consoleintr(c);
-			}
+			// keyboard input, or room for more output
+			uartintr();
 		}
 		else if (DISK_IRQ == irq) {
 			disk_intr();
@@ -218,11 +229,21 @@ int devintr(void) {
 		sbi_set_mie();
 		#endif 
 
+		lat_end(LAT_INTR, t0);
+		return 1;
+	}
+	else if (0x8000000000000001L == scause) {
+		// an IPI from kickidle(); scheduler() looks again
+		// for work once we return.
+		w_sip(r_sip() & ~2);
 		return 1;
 	}
 	else if (0x8000000000000005L == scause) {
-		timer_tick();
-		return 2;
+		CPUSTAT_INC(timer);
+		prof_sample();
+		which = timer_tick() ? 2 : 1;
+		lat_end(LAT_INTR, t0);
+		return which;
 	}
 	else { return 0;}
 }
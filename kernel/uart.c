@@ -1,5 +1,18 @@
 //
-// low-level driver routines for 16550a UART.
+// low-level driver routines for the console UART:
+// the 16550a on qemu, and the UARTHS on k210.
+//
+// write()s to the console are queued in a ring and fed to
+// the UART's FIFO, first by the writer and then by the
+// transmit interrupt whenever the FIFO runs low. The kernel's
+// own printf() goes out a character at a time with
+// uartputc_sync(), which waits for the FIFO, so that it works
+// with interrupts off and in a panic. Input is read out of the
+// FIFO by the receive interrupt and passed to consoleintr().
+//
+// The registers are only mapped at UART_V once paging is on,
+// so until uartinit() (and on a hart without paging yet)
+// output goes through SBI instead.
 //
 
 
@@ -10,11 +23,16 @@
 #include "include/spinlock.h"
 #include "include/proc.h"
 #include "include/intr.h"
+#include "include/console.h"
+#include "include/uart.h"
+#include "include/sbi.h"
+
+#ifdef QEMU
 
 // the UART control registers are memory-mapped
-// at address UART0. this macro returns the
+// at address UART_V. this macro returns the
 // address of one of the registers.
-#define Reg(reg) ((volatile unsigned char *)(UART + reg))
+#define Reg(reg) ((volatile unsigned char *)(UART_V + reg))
 
 // the UART control registers.
 // some have different meanings for
@@ -23,8 +41,8 @@
 #define RHR 0                 // receive holding register (for input bytes)
 #define THR 0                 // transmit holding register (for output bytes)
 #define IER 1                 // interrupt enable register
-#define IER_TX_ENABLE (1<<0)
-#define IER_RX_ENABLE (1<<1)
+#define IER_TX_ENABLE (1<<1)
+#define IER_RX_ENABLE (1<<0)
 #define FCR 2                 // FIFO control register
 #define FCR_FIFO_ENABLE (1<<0)
 #define FCR_FIFO_CLEAR (3<<1) // clear the content of the two FIFOs
@@ -34,24 +52,15 @@
 #define LCR_BAUD_LATCH (1<<7) // special mode to set baud rate
 #define LSR 5                 // line status register
 #define LSR_RX_READY (1<<0)   // input is waiting to be read from RHR
-#define LSR_TX_IDLE (1<<5)    // THR can accept another character to send
+#define LSR_TX_IDLE (1<<5)    // THR and the transmit FIFO are empty
 
 #define ReadReg(reg) (*(Reg(reg)))
 #define WriteReg(reg, v) (*(Reg(reg)) = (v))
 
-// the transmit output buffer.
-struct spinlock uart_tx_lock;
-#define UART_TX_BUF_SIZE 32
-char uart_tx_buf[UART_TX_BUF_SIZE];
-int uart_tx_w; // write next to uart_tx_buf[uart_tx_w++]
-int uart_tx_r; // read next from uart_tx_buf[uar_tx_r++]
-
-extern volatile int panicked; // from printf.c
+#define TX_FIFO 16            // bytes the transmit FIFO holds
 
-void uartstart();
-
-void
-uartinit(void)
+static void
+hwinit(void)
 {
   // disable interrupts.
   WriteReg(IER, 0x00);
@@ -72,108 +81,201 @@ uartinit(void)
   // reset and enable FIFOs.
   WriteReg(FCR, FCR_FIFO_ENABLE | FCR_FIFO_CLEAR);
 
-  // enable transmit and receive interrupts.
-  WriteReg(IER, IER_TX_ENABLE | IER_RX_ENABLE);
+  // enable receive interrupts.
+  WriteReg(IER, IER_RX_ENABLE);
+}
 
-    uart_tx_w = uart_tx_r = 0;
+// how many bytes the UART can take right now.
+static int
+hwtxroom(void)
+{
+  // the 16550 only says whether its FIFO is empty.
+  return (ReadReg(LSR) & LSR_TX_IDLE) ? TX_FIFO : 0;
+}
 
-  initlock(&uart_tx_lock, "uart");
+static void
+hwputc(int c)
+{
+  WriteReg(THR, c);
 }
 
-// add a character to the output buffer and tell the
-// UART to start sending if it isn't already.
-// blocks if the output buffer is full.
-// because it may block, it can't be called
-// from interrupts; it's only suitable for use
-// by write().
-void
-uartputc(int c)
+// read one input character, or -1 if none is waiting.
+static int
+hwgetc(void)
 {
-  acquire(&uart_tx_lock);
+  if(ReadReg(LSR) & LSR_RX_READY)
+    return ReadReg(RHR);
+  return -1;
+}
 
-  if(panicked){
-    for(;;)
-      ;
-  }
+// ask for an interrupt when the UART can take more output.
+static void
+hwtxintr(int on)
+{
+  WriteReg(IER, IER_RX_ENABLE | (on ? IER_TX_ENABLE : 0));
+}
 
-  while(1){
-    if(((uart_tx_w + 1) % UART_TX_BUF_SIZE) == uart_tx_r){
-      // buffer is full.
-      // wait for uartstart() to open up space in the buffer.
-      sleep(&uart_tx_r, &uart_tx_lock);
-    } else {
-      uart_tx_buf[uart_tx_w] = c;
-      uart_tx_w = (uart_tx_w + 1) % UART_TX_BUF_SIZE;
-      uartstart();
-      release(&uart_tx_lock);
-      return;
-    }
-  }
+#else
+
+// k210 UARTHS registers, 32 bits wide.
+#define Reg(reg) ((volatile uint32 *)(UART_V + reg))
+
+#define TXDATA  0x00          // write a byte; bit 31 reads as FIFO full
+#define RXDATA  0x04          // read a byte; bit 31 set if FIFO empty
+#define TXCTRL  0x08
+#define TXCTRL_TXEN   (1<<0)
+#define TXCTRL_TXCNT(n) ((n)<<16) // watermark: interrupt below n entries
+#define RXCTRL  0x0c
+#define RXCTRL_RXEN   (1<<0)
+#define RXCTRL_RXCNT(n) ((n)<<16) // watermark: interrupt above n entries
+#define IE      0x10          // interrupt enable
+#define IE_TXWM (1<<0)
+#define IE_RXWM (1<<1)
+#define IP      0x14          // interrupt pending
+#define FIFO_FULL  (1U<<31)
+#define FIFO_EMPTY (1U<<31)
+
+#define ReadReg(reg) (*(Reg(reg)))
+#define WriteReg(reg, v) (*(Reg(reg)) = (v))
+
+#define TX_FIFO 8             // bytes the transmit FIFO holds
+
+static void
+hwinit(void)
+{
+  // keep the baud rate RustSBI set up.
+  WriteReg(IE, 0);
+  WriteReg(TXCTRL, TXCTRL_TXEN | TXCTRL_TXCNT(TX_FIFO / 2));
+  WriteReg(RXCTRL, RXCTRL_RXEN | RXCTRL_RXCNT(0));
+  WriteReg(IE, IE_RXWM);
+}
+
+static int
+hwtxroom(void)
+{
+  // UARTHS can only say whether its FIFO is full.
+  return (ReadReg(TXDATA) & FIFO_FULL) ? 0 : 1;
+}
+
+static void
+hwputc(int c)
+{
+  WriteReg(TXDATA, c & 0xff);
 }
 
-// alternate version of uartputc() that doesn't 
-// use interrupts, for use by kernel printf() and
-// to echo characters. it spins waiting for the uart's
-// output register to be empty.
+static int
+hwgetc(void)
+{
+  uint32 c = ReadReg(RXDATA);
+
+  if(c & FIFO_EMPTY)
+    return -1;
+  return c & 0xff;
+}
+
+static void
+hwtxintr(int on)
+{
+  WriteReg(IE, IE_RXWM | (on ? IE_TXWM : 0));
+}
+
+#endif
+
+// the transmit output buffer.
+static struct {
+  struct spinlock lock;
+#define UART_TX_BUF_SIZE 1024
+  char buf[UART_TX_BUF_SIZE];
+  uint r;         // read next from buf[r % UART_TX_BUF_SIZE]
+  uint w;         // write next to buf[w % UART_TX_BUF_SIZE]
+  int waiting;    // a writer sleeps for room
+} tx;
+
+extern volatile int panicked; // from printf.c
+
+static volatile int ready;    // uartinit() has run
+
+// call on hart 0 once paging is on.
+void
+uartinit(void)
+{
+  initlock(&tx.lock, "uart");
+  tx.r = tx.w = 0;
+  tx.waiting = 0;
+  hwinit();
+  __sync_synchronize();
+  ready = 1;
+}
+
+// write one character and wait for the UART to take it,
+// for printf() and echoing input. if another hart has
+// panicked, stop here.
 void
 uartputc_sync(int c)
 {
   push_off();
-
   if(panicked){
     for(;;)
       ;
   }
-
-  // wait for Transmit Holding Empty to be set in LSR.
-  while((ReadReg(LSR) & LSR_TX_IDLE) == 0)
-    ;
-  WriteReg(THR, c);
-
+  if(!ready || r_satp() == 0){
+    sbi_console_putchar(c);
+  } else {
+    while(hwtxroom() == 0)
+      ;
+    hwputc(c);
+  }
   pop_off();
 }
 
-// if the UART is idle, and a character is waiting
-// in the transmit buffer, send it.
-// caller must hold uart_tx_lock.
+// move queued output into the UART's FIFO while it
+// has room, and have the UART interrupt when it wants
+// more if there is more.
+// caller must hold tx.lock.
 // called from both the top- and bottom-half.
-void
-uartstart()
+static void
+uartstart(void)
 {
-  while(1){
-    if(uart_tx_w == uart_tx_r){
-      // transmit buffer is empty.
-      return;
-    }
-    
-    if((ReadReg(LSR) & LSR_TX_IDLE) == 0){
-      // the UART transmit holding register is full,
-      // so we cannot give it another byte.
-      // it will interrupt when it's ready for a new byte.
-      return;
-    }
-    
-    int c = uart_tx_buf[uart_tx_r];
-    uart_tx_r = (uart_tx_r + 1) % UART_TX_BUF_SIZE;
-    
-    // maybe uartputc() is waiting for space in the buffer.
-    wakeup(&uart_tx_r);
-    
-    WriteReg(THR, c);
+  int room;
+
+  while(tx.r != tx.w && (room = hwtxroom()) > 0){
+    while(room-- > 0 && tx.r != tx.w)
+      hwputc(tx.buf[tx.r++ % UART_TX_BUF_SIZE]);
+  }
+  hwtxintr(tx.r != tx.w);
+
+  // maybe uartwrite() is waiting for space in the buffer.
+  if(tx.waiting && tx.w - tx.r < UART_TX_BUF_SIZE){
+    tx.waiting = 0;
+    wakeup(&tx.r);
   }
 }
 
-// read one input character from the UART.
-// return -1 if none is waiting.
-int
-uartgetc(void)
+// queue n bytes for output and start sending them,
+// sleeping for room while the buffer is full.
+// for write()s to the console only.
+void
+uartwrite(const char *s, int n)
 {
-  if(ReadReg(LSR) & 0x01){
-    // input data is ready.
-    return ReadReg(RHR);
-  } else {
-    return -1;
+  acquire(&tx.lock);
+  if(panicked){
+    for(;;)
+      ;
+  }
+  while(n > 0){
+    if(tx.w - tx.r == UART_TX_BUF_SIZE){
+      uartstart();
+      if(tx.w - tx.r == UART_TX_BUF_SIZE){
+        tx.waiting = 1;
+        sleep(&tx.r, &tx.lock);
+      }
+      continue;
+    }
+    tx.buf[tx.w++ % UART_TX_BUF_SIZE] = *s++;
+    n--;
   }
+  uartstart();
+  release(&tx.lock);
 }
 
 // handle a uart interrupt, raised because input has
@@ -182,16 +284,14 @@ uartgetc(void)
 void
 uartintr(void)
 {
+  int c;
+
   // read and process incoming characters.
-  while(1){
-    int c = uartgetc();
-    if(c == -1)
-      break;
+  while((c = hwgetc()) != -1)
     consoleintr(c);
-  }
 
   // send buffered characters.
-  acquire(&uart_tx_lock);
+  acquire(&tx.lock);
   uartstart();
-  release(&uart_tx_lock);
+  release(&tx.lock);
 }
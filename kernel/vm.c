@@ -609,6 +609,39 @@ kvmfreeusr(pagetable_t kpt)
   }
 }
 
+// Make the user part of knew share kpt's page-table pages, so
+// that user mappings later added through either one show up in
+// both. Top-level entries kpt lacks are allocated first.
+// Return 0 on success, -1 if out of memory.
+int
+kvmshareusr(pagetable_t kpt, pagetable_t knew)
+{
+  pagetable_t pt;
+
+  for (int i = 0; i < PX(2, MAXUVA); i++) {
+    if ((kpt[i] & PTE_V) == 0) {
+      if ((pt = (pagetable_t) kalloc()) == NULL)
+        return -1;
+      memset(pt, 0, PGSIZE);
+      kpt[i] = PA2PTE(pt) | PTE_V;
+    }
+  }
+  for (int i = 0; i < PX(2, MAXUVA); i++) {
+    knew[i] = kpt[i];
+  }
+  return 0;
+}
+
+// Drop the user part that kvmshareusr() made kpt share,
+// without freeing it.
+void
+kvmunshareusr(pagetable_t kpt)
+{
+  for (int i = 0; i < PX(2, MAXUVA); i++) {
+    kpt[i] = 0;
+  }
+}
+
 void
 kvmfree(pagetable_t kpt, int stack_free)
 {
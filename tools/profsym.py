@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# Turn the samples written by the prof user program into a flat
+# profile by function.
+#
+#   python3 tools/profsym.py prof.out
+#
+# Kernel pcs are looked up in target/kernel.sym and user pcs in
+# xv6-user/<name>.sym, both made by `make`; pass -k / -u to use
+# other files or directories.
+
+import argparse
+import bisect
+import os
+import sys
+from collections import Counter
+
+
+def load_syms(path):
+    """Read an objdump -t | sed symbol file: one "addr name" per line."""
+    syms = []
+    try:
+        with open(path) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) != 2:
+                    continue
+                try:
+                    addr = int(parts[0], 16)
+                except ValueError:
+                    continue
+                name = parts[1]
+                if name.startswith('.') or name.endswith('.c') or name.endswith('.S'):
+                    continue
+                syms.append((addr, name))
+    except OSError:
+        return None
+    syms.sort()
+    return ([a for a, _ in syms], [n for _, n in syms])
+
+
+def lookup(table, pc):
+    if not table or not table[0]:
+        return '0x%x' % pc
+    addrs, names = table
+    i = bisect.bisect_right(addrs, pc) - 1
+    if i < 0:
+        return '0x%x' % pc
+    return names[i]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument('samples', help='file written by prof on xv6')
+    ap.add_argument('-k', '--kernel', default='target/kernel.sym',
+                    help='kernel symbol file (default %(default)s)')
+    ap.add_argument('-u', '--user', default='xv6-user',
+                    help='directory of user .sym files (default %(default)s)')
+    ap.add_argument('-n', type=int, default=30,
+                    help='show this many functions (default %(default)s)')
+    ap.add_argument('--by-pid', action='store_true',
+                    help='count each process separately')
+    args = ap.parse_args()
+
+    kernel = load_syms(args.kernel)
+    if kernel is None:
+        print('profsym: no %s; kernel pcs are left as numbers' % args.kernel,
+              file=sys.stderr)
+    users = {}
+    counts = Counter()
+    total = 0
+
+    with open(args.samples) as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) != 5:
+                continue
+            mode, _cpu, pid, name, pc = parts
+            pc = int(pc, 16)
+            if mode == 'k':
+                sym = '[k] ' + lookup(kernel, pc)
+            else:
+                if name not in users:
+                    users[name] = load_syms(os.path.join(args.user, name + '.sym'))
+                sym = '[u] %s:%s' % (name, lookup(users[name], pc))
+            if args.by_pid:
+                sym = '%5s %s' % (pid, sym)
+            counts[sym] += 1
+            total += 1
+
+    if total == 0:
+        print('profsym: no samples', file=sys.stderr)
+        return 1
+    print('%8s %6s  %s' % ('samples', '%', 'function'))
+    for sym, n in counts.most_common(args.n):
+        print('%8d %6.2f  %s' % (n, 100.0 * n / total, sym))
+    print('%8d %6.2f  total' % (total, 100.0))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
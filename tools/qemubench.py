@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+# Run the bench user program under QEMU and check it against a
+# baseline; `make bench` calls this after building for qemu.
+#
+#   python3 tools/qemubench.py [options] [-- BENCH ARGS...]
+#
+# Packs a FAT32 image with the user programs and an /init.conf that
+# runs bench, boots it headless, collects bench's
+#   name iterations ticks_per_op
+# lines from the console, writes them as CSV and JSON, and prints
+# each benchmark's change from the baseline. Exits 1 if a
+# benchmark got slower by more than --threshold percent, or if
+# bench did not finish within --timeout seconds; 2 if there is
+# no baseline yet or a tool is missing.
+#
+# Needs qemu-system-riscv64, mkfs.vfat and mcopy (mtools); no
+# root, since the image is never mounted.
+
+import argparse
+import glob
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+
+HEADER = re.compile(r'# bench clk_freq (\d+) scale (\d+) runs (\d+)')
+RESULT = re.compile(r'^([a-z_0-9]+) (\d+) (\d+)\s*$')
+DONE = '# bench done'
+
+
+def run(cmd):
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+
+
+def make_image(path, user, size_mb, conf):
+    with open(path, 'wb') as f:
+        f.truncate(size_mb << 20)
+    run(['mkfs.vfat', '-F', '32', path])
+    run(['mmd', '-i', path, '::/bin'])
+    for prog in sorted(glob.glob(os.path.join(user, '_*'))):
+        name = os.path.basename(prog)[1:]
+        run(['mcopy', '-i', path, prog, '::/' + name])
+        run(['mcopy', '-i', path, prog, '::/bin/' + name])
+    conffile = path + '.conf'
+    with open(conffile, 'w') as f:
+        f.write(conf)
+    run(['mcopy', '-i', path, conffile, '::/init.conf'])
+    os.unlink(conffile)
+
+
+def boot(args, image, log):
+    """Boot QEMU, tee the console to log, and return its lines
+    once bench is done, or None on timeout."""
+    cmd = [args.qemu, '-machine', 'virt', '-kernel', args.kernel,
+           '-m', '8M', '-nographic', '-smp', str(args.cpus),
+           '-bios', args.sbi,
+           '-drive', 'file=%s,if=none,format=raw,id=x0' % image,
+           '-device', 'virtio-blk-device,drive=x0,bus=virtio-mmio-bus.0']
+    qemu = subprocess.Popen(cmd, stdin=subprocess.DEVNULL,
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    os.set_blocking(qemu.stdout.fileno(), False)
+    deadline = time.time() + args.timeout
+    out = b''
+    finished = False
+    with open(log, 'wb') as f:
+        while time.time() < deadline and qemu.poll() is None:
+            chunk = qemu.stdout.read()
+            if chunk:
+                f.write(chunk)
+                f.flush()
+                out += chunk
+                if DONE.encode() in out:
+                    finished = True
+                    break
+            else:
+                time.sleep(0.05)
+    qemu.kill()
+    qemu.wait()
+    if not finished:
+        return None
+    return out.decode('utf-8', 'replace').replace('\r', '').split('\n')
+
+
+def parse(lines):
+    """The header's clock rate and {name: (iterations, ticks/op)}."""
+    clk = None
+    results = {}
+    for line in lines:
+        m = HEADER.search(line)
+        if m:
+            clk = int(m.group(1))
+            continue
+        if clk is None:
+            continue
+        if DONE in line:
+            break
+        m = RESULT.match(line)
+        if m:
+            results[m.group(1)] = (int(m.group(2)), int(m.group(3)))
+    return clk, results
+
+
+def write_results(clk, results, csvpath, jsonpath):
+    with open(csvpath, 'w') as f:
+        f.write('name,iterations,ticks_per_op,ns_per_op\n')
+        for name, (n, ticks) in results.items():
+            f.write('%s,%d,%d,%d\n' % (name, n, ticks, ticks * 10**9 // clk))
+    with open(jsonpath, 'w') as f:
+        json.dump({'clk_freq': clk,
+                   'results': {name: {'iterations': n, 'ticks_per_op': t}
+                               for name, (n, t) in results.items()}},
+                  f, indent=2, sort_keys=True)
+        f.write('\n')
+
+
+def compare(results, baseline, threshold):
+    """Print old vs new; return the names that regressed."""
+    old = baseline.get('results', {})
+    worse = []
+    print('%-16s %12s %12s %8s' % ('benchmark', 'baseline', 'now', 'change'))
+    for name, (_, ticks) in results.items():
+        if name not in old:
+            print('%-16s %12s %12d %8s' % (name, '-', ticks, 'new'))
+            continue
+        before = old[name]['ticks_per_op']
+        change = 100.0 * (ticks - before) / before if before else 0.0
+        flag = ''
+        if change > threshold:
+            flag = '  <-- slower'
+            worse.append(name)
+        print('%-16s %12d %12d %+7.1f%%%s' % (name, before, ticks, change, flag))
+    for name in old:
+        if name not in results:
+            print('%-16s %12d %12s %8s' % (name, old[name]['ticks_per_op'], '-', 'gone'))
+    return worse
+
+
+def main():
+    ap = argparse.ArgumentParser(description='run bench under QEMU')
+    ap.add_argument('--kernel', default='target/kernel')
+    ap.add_argument('--sbi', default='bootloader/SBI/sbi-qemu')
+    ap.add_argument('--user', default='xv6-user', help='directory of _programs')
+    ap.add_argument('--qemu', default='qemu-system-riscv64')
+    ap.add_argument('--cpus', type=int, default=2)
+    ap.add_argument('--out', default='target', help='where results go')
+    ap.add_argument('--baseline', default='tools/bench-baseline.json')
+    ap.add_argument('--update-baseline', action='store_true',
+                    help='save this run as the baseline instead of comparing')
+    ap.add_argument('--threshold', type=float, default=10.0,
+                    help='percent slowdown that fails (default %(default)s)')
+    ap.add_argument('--timeout', type=int, default=600, help='seconds')
+    ap.add_argument('--image-mb', type=int, default=64)
+    ap.add_argument('bench_args', nargs='*', help='arguments for bench')
+    args = ap.parse_args()
+
+    # Nothing to compare with would pass any kernel; say so
+    # before spending minutes in QEMU.
+    if not args.update_baseline and not os.path.exists(args.baseline):
+        print('qemubench: no baseline %s; run make bench-baseline '
+              '(or this with --update-baseline) first' % args.baseline,
+              file=sys.stderr)
+        return 2
+
+    for tool in (args.qemu, 'mkfs.vfat', 'mcopy'):
+        if shutil.which(tool) is None:
+            print('qemubench: %s not found' % tool, file=sys.stderr)
+            return 2
+
+    os.makedirs(args.out, exist_ok=True)
+    image = os.path.join(args.out, 'bench.img')
+    log = os.path.join(args.out, 'bench.log')
+    make_image(image, args.user, args.image_mb,
+               ' '.join(['bench no -', 'bench'] + args.bench_args) + '\n')
+
+    lines = boot(args, image, log)
+    if lines is None:
+        print('qemubench: bench did not finish in %d s; console in %s'
+              % (args.timeout, log), file=sys.stderr)
+        return 1
+    clk, results = parse(lines)
+    if clk is None or not results:
+        print('qemubench: no results in %s' % log, file=sys.stderr)
+        return 1
+
+    csvpath = os.path.join(args.out, 'bench.csv')
+    jsonpath = os.path.join(args.out, 'bench.json')
+    write_results(clk, results, csvpath, jsonpath)
+    print('qemubench: %d results in %s and %s' % (len(results), csvpath, jsonpath))
+
+    if args.update_baseline:
+        shutil.copyfile(jsonpath, args.baseline)
+        print('qemubench: baseline saved to %s' % args.baseline)
+        return 0
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    if baseline.get('clk_freq') != clk:
+        print('qemubench: baseline clock %s differs from %d; ticks not comparable'
+              % (baseline.get('clk_freq'), clk), file=sys.stderr)
+        return 1
+    worse = compare(results, baseline, args.threshold)
+    if worse:
+        print('qemubench: slower than baseline by over %g%%: %s'
+              % (args.threshold, ' '.join(worse)), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,455 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "kernel/include/fcntl.h"
+#include "xv6-user/user.h"
+
+// bench [-n SCALE] [-r RUNS] [NAME...]
+// kernel microbenchmarks. Each runs RUNS times (default 3) and
+// the fastest run is reported, one line per benchmark:
+//   name iterations ticks_per_op
+// where ticks are of rdtime(), CLK_FREQ to the second; the
+// header line gives CLK_FREQ. Iteration counts are fixed (times
+// SCALE) and the random ones use a fixed seed, so the output of
+// two kernels can be compared line by line. With NAMEs, only
+// the benchmarks whose names start with one of them run.
+//
+// Files are made in and removed from the directory bench.d.
+
+#define DIR     "bench.d"
+#define BLOCK   4096
+#define FILEBLK 256             // blocks in the test file, times SCALE
+#define DEPTH   8
+
+static char buf[BLOCK];
+static char *self;              // our own path, for exec
+static int scale = 1;
+static int nblk;                // blocks in the test file
+
+// Time one run of a benchmark of n operations.
+typedef uint64 (*benchfn)(int n);
+
+static void
+die(char *what)
+{
+  fprintf(stderr, "bench: %s failed\n", what);
+  exit(1);
+}
+
+static uint64
+null_syscall(int n)
+{
+  uint64 t0 = rdtime();
+  for(int i = 0; i < n; i++)
+    getpid();
+  return rdtime() - t0;
+}
+
+static uint64
+fork_exit(int n)
+{
+  uint64 t0 = rdtime();
+  for(int i = 0; i < n; i++){
+    int pid = fork();
+    if(pid < 0)
+      die("fork");
+    if(pid == 0)
+      exit(0);
+    wait(0);
+  }
+  return rdtime() - t0;
+}
+
+static uint64
+fork_exec(int n)
+{
+  char *argv[] = { self, "-exit", 0 };
+  uint64 t0 = rdtime();
+
+  for(int i = 0; i < n; i++){
+    int pid = fork();
+    if(pid < 0)
+      die("fork");
+    if(pid == 0){
+      exec(self, argv);
+      die("exec");
+    }
+    wait(0);
+  }
+  return rdtime() - t0;
+}
+
+// One byte back and forth between two processes; per round trip.
+static uint64
+pipe_lat(int n)
+{
+  int ping[2], pong[2], pid;
+  uint64 t0;
+  char c = 0;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0)
+    die("pipe");
+  if((pid = fork()) < 0)
+    die("fork");
+  if(pid == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit(0);
+  }
+  close(ping[0]);
+  close(pong[1]);
+  t0 = rdtime();
+  for(int i = 0; i < n; i++){
+    if(write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1)
+      die("pipe_lat");
+  }
+  t0 = rdtime() - t0;
+  close(ping[1]);
+  close(pong[0]);
+  wait(0);
+  return t0;
+}
+
+// Blocks of BLOCK bytes through a pipe; per block.
+static uint64
+pipe_bw(int n)
+{
+  int fds[2], pid;
+  uint64 t0;
+
+  if(pipe(fds) < 0)
+    die("pipe");
+  if((pid = fork()) < 0)
+    die("fork");
+  if(pid == 0){
+    close(fds[1]);
+    while(read(fds[0], buf, sizeof(buf)) > 0)
+      ;
+    exit(0);
+  }
+  close(fds[0]);
+  t0 = rdtime();
+  for(int i = 0; i < n; i++)
+    if(write(fds[1], buf, BLOCK) != BLOCK)
+      die("pipe_bw");
+  close(fds[1]);
+  wait(0);            // until the reader has it all
+  return rdtime() - t0;
+}
+
+// Two processes on one hart taking turns; per switch.
+static uint64
+ctxsw(int n)
+{
+  int pid, fds[2];
+  uint64 t0;
+  char c;
+
+  if(sched_setaffinity(0, 1) < 0)
+    die("sched_setaffinity");
+  if(pipe(fds) < 0)
+    die("pipe");
+  if((pid = fork()) < 0)
+    die("fork");
+  if(pid == 0){
+    close(fds[0]);
+    write(fds[1], "", 1);
+    for(int i = 0; i < n / 2; i++)
+      sched_yield();
+    exit(0);
+  }
+  close(fds[1]);
+  read(fds[0], &c, 1);   // the child is running too
+  close(fds[0]);
+  t0 = rdtime();
+  for(int i = 0; i < n / 2; i++)
+    sched_yield();
+  wait(0);
+  t0 = rdtime() - t0;
+  sched_setaffinity(0, ~0UL);
+  return t0;
+}
+
+static int
+openfile(int mode)
+{
+  int fd = open(DIR "/file", mode);
+  if(fd < 0)
+    die("open " DIR "/file");
+  return fd;
+}
+
+// n blocks written to a new file; per block.
+static uint64
+file_seqwrite(int n)
+{
+  uint64 t0 = rdtime();
+  int fd = openfile(O_CREATE | O_WRONLY | O_TRUNC);
+
+  for(int i = 0; i < n; i++)
+    if(write(fd, buf, BLOCK) != BLOCK)
+      die("write");
+  close(fd);
+  return rdtime() - t0;
+}
+
+// The file file_seqwrite made, read back; per block.
+static uint64
+file_seqread(int n)
+{
+  uint64 t0 = rdtime();
+  int fd = openfile(O_RDONLY);
+
+  for(int i = 0; i < n; i++)
+    if(read(fd, buf, BLOCK) != BLOCK)
+      die("read");
+  close(fd);
+  return rdtime() - t0;
+}
+
+static uint
+rnd(void)
+{
+  static uint seed;
+
+  if(seed == 0)
+    seed = 12345;
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static uint64
+file_random(int n, int writing)
+{
+  int fd = openfile(writing ? O_RDWR : O_RDONLY);
+  uint64 t0 = rdtime();
+
+  for(int i = 0; i < n; i++){
+    if(lseek(fd, rnd() % nblk * BLOCK, SEEK_SET) < 0)
+      die("lseek");
+    if((writing ? write(fd, buf, BLOCK) : read(fd, buf, BLOCK)) != BLOCK)
+      die(writing ? "write" : "read");
+  }
+  t0 = rdtime() - t0;
+  close(fd);
+  return t0;
+}
+
+static uint64
+file_randread(int n)
+{
+  return file_random(n, 0);
+}
+
+static uint64
+file_randwrite(int n)
+{
+  return file_random(n, 1);
+}
+
+// open(O_CREATE), close and remove; per file.
+static uint64
+create_delete(int n)
+{
+  char name[] = DIR "/cXXX";
+  int len = strlen(name);
+  uint64 t0 = rdtime();
+
+  for(int i = 0; i < n; i++){
+    name[len - 3] = 'a' + i % 26;
+    name[len - 2] = 'a' + i / 26 % 26;
+    name[len - 1] = 'a' + i / 676 % 26;
+    int fd = open(name, O_CREATE | O_WRONLY);
+    if(fd < 0)
+      die("create");
+    close(fd);
+    if(remove(name) < 0)
+      die("remove");
+  }
+  return rdtime() - t0;
+}
+
+// Open a file depth directories down: DIR/d/d/.../f.
+static uint64
+lookup(int n, int depth)
+{
+  char path[64];
+  int fd;
+  uint64 t0;
+
+  strcpy(path, DIR);
+  for(int i = 0; i < depth; i++)
+    strcpy(path + strlen(path), "/d");
+  strcpy(path + strlen(path), "/f");
+  t0 = rdtime();
+  for(int i = 0; i < n; i++){
+    if((fd = open(path, O_RDONLY)) < 0)
+      die("open");
+    close(fd);
+  }
+  return rdtime() - t0;
+}
+
+static uint64
+lookup_depth1(int n)
+{
+  return lookup(n, 1);
+}
+
+static uint64
+lookup_depth4(int n)
+{
+  return lookup(n, 4);
+}
+
+static uint64
+lookup_depth8(int n)
+{
+  return lookup(n, DEPTH);
+}
+
+// Grow the heap a page at a time, touching each; per page.
+static uint64
+sbrk_grow(int n)
+{
+  uint64 t0 = rdtime();
+  char *p;
+
+  for(int i = 0; i < n; i++){
+    if((p = sbrk(BLOCK)) == (char *)-1)
+      die("sbrk");
+    p[0] = 1;
+  }
+  t0 = rdtime() - t0;
+  sbrk(-n * BLOCK);
+  return t0;
+}
+
+static struct bench {
+  char *name;
+  benchfn fn;
+  int n;
+} benches[] = {
+  { "null_syscall",   null_syscall,   10000 },
+  { "fork_exit",      fork_exit,      100 },
+  { "fork_exec",      fork_exec,      50 },
+  { "pipe_lat",       pipe_lat,       2000 },
+  { "pipe_bw",        pipe_bw,        1024 },
+  { "ctxsw",          ctxsw,          2000 },
+  { "file_seqwrite",  file_seqwrite,  FILEBLK },
+  { "file_seqread",   file_seqread,   FILEBLK },
+  { "file_randread",  file_randread,  FILEBLK },
+  { "file_randwrite", file_randwrite, FILEBLK },
+  { "create_delete",  create_delete,  100 },
+  { "lookup_depth1",  lookup_depth1,  1000 },
+  { "lookup_depth4",  lookup_depth4,  1000 },
+  { "lookup_depth8",  lookup_depth8,  1000 },
+  { "sbrk_grow",      sbrk_grow,      256 },
+};
+
+// The directories and file the lookups walk.
+static void
+setup(void)
+{
+  char path[64];
+  int fd;
+
+  mkdir(DIR);
+  strcpy(path, DIR);
+  for(int i = 0; i < DEPTH; i++){
+    strcpy(path + strlen(path), "/d");
+    mkdir(path);
+  }
+  for(int depth = 1; depth <= DEPTH; depth++){
+    strcpy(path, DIR);
+    for(int i = 0; i < depth; i++)
+      strcpy(path + strlen(path), "/d");
+    strcpy(path + strlen(path), "/f");
+    if((fd = open(path, O_CREATE | O_WRONLY)) < 0)
+      die("setup");
+    close(fd);
+  }
+}
+
+static void
+cleanup(void)
+{
+  char path[64];
+  int len;
+
+  remove(DIR "/file");
+  for(int depth = DEPTH; depth >= 1; depth--){
+    strcpy(path, DIR);
+    for(int i = 0; i < depth; i++)
+      strcpy(path + strlen(path), "/d");
+    len = strlen(path);
+    strcpy(path + len, "/f");
+    remove(path);
+    path[len] = '\0';
+    remove(path);
+  }
+  remove(DIR);
+}
+
+static int
+prefix(char *s, char *pre)
+{
+  while(*pre && *s == *pre)
+    s++, pre++;
+  return *pre == '\0';
+}
+
+static int
+wanted(char *name, int argc, char **argv, int first)
+{
+  if(first == argc)
+    return 1;
+  for(int i = first; i < argc; i++)
+    if(prefix(name, argv[i]))
+      return 1;
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, r, runs = 3, n;
+  uint64 t, best;
+
+  if(argc == 2 && strcmp(argv[1], "-exit") == 0)
+    exit(0);              // the program fork_exec runs
+  self = argv[0];
+  for(i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2){
+    if(strcmp(argv[i], "-n") == 0)
+      scale = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-r") == 0)
+      runs = atoi(argv[i + 1]);
+    else
+      break;
+  }
+  if(scale <= 0 || runs <= 0 || (i < argc && argv[i][0] == '-')){
+    fprintf(stderr, "usage: bench [-n SCALE] [-r RUNS] [NAME...]\n");
+    exit(1);
+  }
+
+  nblk = FILEBLK * scale;
+  setup();
+  printf("# bench clk_freq %d scale %d runs %d\n", CLK_FREQ, scale, runs);
+  for(struct bench *b = benches; b < benches + NELEM(benches); b++){
+    if(!wanted(b->name, argc, argv, i))
+      continue;
+    // The other file benchmarks need the file this one makes.
+    if(prefix(b->name, "file_") && b->fn != file_seqwrite)
+      file_seqwrite(nblk);
+    n = b->n * scale;
+    best = ~0UL;
+    for(r = 0; r < runs; r++)
+      if((t = b->fn(n)) < best)
+        best = t;
+    printf("%s %d %d\n", b->name, n, (int)(best / n));
+  }
+  printf("# bench done\n");
+  cleanup();
+  exit(0);
+}
@@ -9,14 +9,21 @@ cat(int fd)
 {
   int n;
 
+  // When fd or stdout is a pipe, let the kernel move the data;
+  // otherwise (e.g. console to console) copy it through buf.
+  while((n = splice(fd, 1, 64 * 1024)) > 0)
+    ;
+  if(n == 0)
+    return;
+
   while((n = read(fd, buf, sizeof(buf))) > 0) {
     if (write(1, buf, n) != n) {
-      fprintf(2, "cat: write error\n");
+      fprintf(stderr, "cat: write error\n");
       exit(1);
     }
   }
   if(n < 0){
-    fprintf(2, "cat: read error\n");
+    fprintf(stderr, "cat: read error\n");
     exit(1);
   }
 }
@@ -33,7 +40,7 @@ main(int argc, char *argv[])
 
   for(i = 1; i < argc; i++){
     if((fd = open(argv[i], 0)) < 0){
-      fprintf(2, "cat: cannot open %s\n", argv[i]);
+      fprintf(stderr, "cat: cannot open %s\n", argv[i]);
       exit(1);
     }
     cat(fd);
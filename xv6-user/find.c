@@ -10,11 +10,11 @@ void find(char *filename)
     int fd;
     struct stat st;
     if ((fd = open(path, O_RDONLY)) < 0) {
-        fprintf(2, "find: cannot open %s\n", path);
+        fprintf(stderr, "find: cannot open %s\n", path);
         return;
     }
     if (fstat(fd, &st) < 0) {
-        fprintf(2, "find: cannot stat %s\n", path);
+        fprintf(stderr, "find: cannot stat %s\n", path);
         close(fd);
         return;
     }
@@ -23,7 +23,7 @@ void find(char *filename)
         return;
     }
     if (strlen(path) + 255 + 2 > sizeof(path)) {
-        fprintf(2, "find: path too long\n");
+        fprintf(stderr, "find: path too long\n");
         close(fd);
         return;
     }
@@ -38,7 +38,7 @@ void find(char *filename)
             continue;
         }
         if (strcmp(p, filename) == 0) {
-            fprintf(1, "%s\n", path);
+            fprintf(stdout, "%s\n", path);
         }
         find(filename);
     }
@@ -50,7 +50,7 @@ void find(char *filename)
 int main(int argc, char *argv[])
 {
     if (argc < 3) {
-        fprintf(2, "Usage: find DIR FILENAME\n");
+        fprintf(stderr, "Usage: find DIR FILENAME\n");
         exit(0);
     } else {
         strcpy(path, argv[1]);
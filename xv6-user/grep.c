@@ -22,7 +22,7 @@ grep(char *pattern, int fd)
       *q = 0;
       if(match(pattern, p)){
         *q = '\n';
-        write(1, p, q+1 - p);
+        fwrite(p, 1, q+1 - p, stdout);
       }
       p = q+1;
     }
@@ -40,7 +40,7 @@ main(int argc, char *argv[])
   char *pattern;
 
   if(argc <= 1){
-    fprintf(2, "usage: grep pattern [file ...]\n");
+    fprintf(stderr, "usage: grep pattern [file ...]\n");
     exit(1);
   }
   pattern = argv[1];
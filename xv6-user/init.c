@@ -1,17 +1,256 @@
 // init: The initial user-level program
+//
+// Starts the services listed in /init.conf, one per line:
+//
+//   # name   restart      after    command
+//   mkdirs   no           -        mkdir /tmp
+//   bench    no           mkdirs   bench -n 2
+//   sh       always       bench    sh
+//
+// restart is no, on-failure or always. after is a comma-separated
+// list of services that must be up first, or "-": a service that
+// restarts "always" is up once it has started, any other once it
+// has exited with status 0. Everything whose services are up is
+// started at once, so independent services start in parallel.
+// Without /init.conf, init just keeps a shell running.
 
 #include "kernel/include/types.h"
+#include "kernel/include/param.h"
 #include "kernel/include/stat.h"
 #include "kernel/include/file.h"
 #include "kernel/include/fcntl.h"
+#include "kernel/include/sysinfo.h"
 #include "xv6-user/user.h"
 
-char *argv[] = { "sh", 0 };
+#define NSERVICE  16
+#define NARG      16
+#define MAXAFTER  4
+#define NAMELEN   16
+#define FASTFAIL  5     // restarts within a second before giving up
+
+enum { R_NO, R_ONFAILURE, R_ALWAYS };
+enum { WAITING, RUNNING, DONE, FAILED };
+
+struct service {
+  char name[NAMELEN];
+  int restart;
+  int after[MAXAFTER];    // indices into services
+  int nafter;
+  char *argv[NARG + 1];
+  int state;
+  int started;            // has been started at least once
+  int pid;
+  int fastfails;
+  uint64 starttime;       // rdtime() at the last start
+};
+
+static struct service services[NSERVICE];
+static int nservice;
+static uint64 boottime;
+
+static char *defargv[] = { "sh", 0 };
+
+static uint
+ms(uint64 t)
+{
+  return t * 1000 / CLK_FREQ;
+}
+
+static struct service*
+lookup(char *name)
+{
+  for(int i = 0; i < nservice; i++)
+    if(strcmp(services[i].name, name) == 0)
+      return &services[i];
+  return 0;
+}
+
+static char*
+copystr(char *s)
+{
+  char *p = malloc(strlen(s) + 1);
+
+  if(p == 0){
+    printf("init: out of memory\n");
+    exit(1);
+  }
+  strcpy(p, s);
+  return p;
+}
+
+// Split line into whitespace-separated words, in place.
+static int
+split(char *line, char **words, int max)
+{
+  int n = 0;
+
+  while(n < max){
+    while(*line && strchr(" \t\r\n", *line))
+      *line++ = '\0';
+    if(*line == '\0' || *line == '#')
+      break;
+    words[n++] = line;
+    while(*line && !strchr(" \t\r\n", *line))
+      line++;
+  }
+  *line = '\0';
+  return n;
+}
+
+// Read /init.conf. The services a line names as "after" must
+// be listed above it, so there can be no cycles.
+static int
+readconf(void)
+{
+  char line[256], *w[4 + NARG], *a, *comma;
+  struct service *s, *dep;
+  int lineno = 0, n, c;
+  FILE *f;
+
+  if((f = fopen("/init.conf", "r")) == 0)
+    return -1;
+  while(fgets(line, sizeof(line), f)){
+    lineno++;
+    if(strchr(line, '\n') == 0 && !feof(f)){
+      printf("init: /init.conf:%d: line too long\n", lineno);
+      while((c = fgetc(f)) != EOF && c != '\n')
+        ;
+      continue;
+    }
+    if((n = split(line, w, NELEM(w))) == 0)
+      continue;
+    // split() stops at NELEM(w) words, so n - 3 > NARG
+    // means there were too many.
+    if(n - 3 > NARG){
+      printf("init: /init.conf:%d: more than %d arguments\n", lineno, NARG);
+      continue;
+    }
+    if(n < 4 || nservice == NSERVICE || strlen(w[0]) >= NAMELEN || lookup(w[0])){
+      printf("init: /init.conf:%d: bad or duplicate service\n", lineno);
+      continue;
+    }
+    s = &services[nservice];
+    memset(s, 0, sizeof(*s));
+    strcpy(s->name, w[0]);
+    if(strcmp(w[1], "no") == 0)
+      s->restart = R_NO;
+    else if(strcmp(w[1], "on-failure") == 0)
+      s->restart = R_ONFAILURE;
+    else if(strcmp(w[1], "always") == 0)
+      s->restart = R_ALWAYS;
+    else {
+      printf("init: /init.conf:%d: unknown restart %s\n", lineno, w[1]);
+      continue;
+    }
+    a = strcmp(w[2], "-") == 0 ? 0 : w[2];
+    for(; a; a = comma){
+      if((comma = strchr(a, ',')) != 0)
+        *comma++ = '\0';
+      if((dep = lookup(a)) == 0 || s->nafter == MAXAFTER){
+        printf("init: /init.conf:%d: %s: no service %s above\n", lineno, s->name, a);
+        s->nafter = -1;
+        break;
+      }
+      s->after[s->nafter++] = dep - services;
+    }
+    if(s->nafter < 0)
+      continue;
+    for(int i = 3; i < n; i++)
+      s->argv[i - 3] = copystr(w[i]);
+    nservice++;
+  }
+  fclose(f);
+  return 0;
+}
+
+static void
+start(struct service *s)
+{
+  int pid = fork();
+
+  if(pid < 0){
+    printf("init: %s: fork failed\n", s->name);
+    s->state = FAILED;
+    return;
+  }
+  if(pid == 0){
+    exec(s->argv[0], s->argv);
+    printf("init: %s: exec %s failed\n", s->name, s->argv[0]);
+    exit(1);
+  }
+  s->pid = pid;
+  s->state = RUNNING;
+  s->starttime = rdtime();
+  if(!s->started)
+    printf("init: started %s, pid %d, %d ms after boot\n",
+           s->name, pid, ms(s->starttime - boottime));
+  s->started = 1;
+}
+
+// Start every waiting service whose services are up; give up
+// on those that wait for one that failed. Repeat until nothing
+// changes, since giving up on one may give up on others.
+static void
+startready(void)
+{
+  struct service *s, *dep;
+  int changed, ready;
+
+  do {
+    changed = 0;
+    for(s = services; s < services + nservice; s++){
+      if(s->state != WAITING)
+        continue;
+      ready = 1;
+      for(int i = 0; i < s->nafter; i++){
+        dep = &services[s->after[i]];
+        if(dep->state == FAILED){
+          printf("init: not starting %s: %s failed\n", s->name, dep->name);
+          s->state = FAILED;
+          changed = 1;
+          break;
+        }
+        if(dep->restart == R_ALWAYS ? !dep->started : dep->state != DONE)
+          ready = 0;
+      }
+      if(s->state == WAITING && ready){
+        start(s);
+        changed = 1;
+      }
+    }
+  } while(changed);
+}
+
+static void
+exited(struct service *s, int status)
+{
+  uint64 now = rdtime();
+
+  s->pid = 0;
+  if(s->restart == R_ALWAYS || (s->restart == R_ONFAILURE && status != 0)){
+    if(now - s->starttime < CLK_FREQ)
+      s->fastfails++;
+    else
+      s->fastfails = 0;
+    if(s->fastfails < FASTFAIL){
+      start(s);
+      return;
+    }
+    printf("init: %s restarting too fast; giving up\n", s->name);
+    s->state = FAILED;
+    return;
+  }
+  if(status != 0)
+    printf("init: %s exited with status %d\n", s->name, status);
+  s->state = status == 0 ? DONE : FAILED;
+}
 
 int
 main(void)
 {
-  int pid, wpid;
+  struct sysinfo info;
+  struct service *s;
+  int pid, status;
 
   // if(open("console", O_RDWR) < 0){
   //   mknod("console", CONSOLE, 0);
@@ -21,32 +260,34 @@ main(void)
   dup(0);  // stdout
   dup(0);  // stderr
 
+  if(sysinfo(&info) == 0)
+    boottime = info.boottime;
+  printf("init: %d ms after boot\n", ms(rdtime() - boottime));
+
+  if(readconf() < 0){
+    strcpy(services[0].name, "sh");
+    services[0].restart = R_ALWAYS;
+    memmove(services[0].argv, defargv, sizeof(defargv));
+    nservice = 1;
+  }
+  startready();
+
   for(;;){
-    printf("init: starting sh\n");
-    pid = fork();
+    // this call to wait() returns if a service exits,
+    // or if a parentless process exits.
+    pid = wait(&status);
     if(pid < 0){
-      printf("init: fork failed\n");
-      exit(1);
+      // nothing left to wait for until someone is orphaned.
+      sleep(10);
+      continue;
     }
-    if(pid == 0){
-      exec("sh", argv);
-      printf("init: exec sh failed\n");
-      exit(1);
-    }
-
-    for(;;){
-      // this call to wait() returns if the shell exits,
-      // or if a parentless process exits.
-      wpid = wait((int *) 0);
-      if(wpid == pid){
-        // the shell exited; restart it.
+    for(s = services; s < services + nservice; s++)
+      if(s->state == RUNNING && s->pid == pid)
         break;
-      } else if(wpid < 0){
-        printf("init: wait returned an error\n");
-        exit(1);
-      } else {
-        // it was a parentless process; do nothing.
-      }
+    if(s < services + nservice){
+      exited(s, status);
+      startready();
     }
+    // otherwise it was a parentless process; do nothing.
   }
 }
@@ -0,0 +1,156 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "kernel/include/sysnum.h"
+#include "kernel/include/latency.h"
+#include "xv6-user/user.h"
+#include "xv6-user/sysnames.h"
+
+// latency [-on | -off | COMMAND [ARGS...]]
+// print how long disk requests, system calls, run-queue waits
+// and interrupts took, as count, mean, 50th and 99th percentile
+// and maximum, in microseconds. With COMMAND, time only while it
+// runs; otherwise show what has been gathered since -on.
+// Percentiles come from log2 buckets, so they are upper bounds
+// good to within a factor of two.
+
+static char *what[] = {
+  [LAT_DISKREAD]  "disk read",
+  [LAT_DISKWRITE] "disk write",
+  [LAT_RUNQ]      "run queue",
+  [LAT_INTR]      "interrupt",
+  [LAT_SYSCALL]   "syscalls",
+};
+
+// Print r_time() units as microseconds, to a tenth.
+static void
+col(uint64 t, int width)
+{
+  char buf[24];
+  int n = 0;
+  uint64 v;
+
+  if(t < (1UL << 40))
+    v = t * 10000000 / CLK_FREQ;
+  else
+    v = t / CLK_FREQ * 10000000;
+  buf[n++] = '0' + v % 10;
+  buf[n++] = '.';
+  v /= 10;
+  do
+    buf[n++] = '0' + v % 10;
+  while((v /= 10) != 0);
+  for(int i = n; i < width; i++)
+    fputc(' ', stdout);
+  while(n > 0)
+    fputc(buf[--n], stdout);
+}
+
+// Upper bound of the bucket holding the p-th percentile.
+static uint64
+percentile(struct lathist *h, int p)
+{
+  uint64 want = (h->count * p + 99) / 100, seen = 0;
+
+  for(int b = 0; b < LAT_NBUCKET; b++){
+    seen += h->bucket[b];
+    if(seen >= want && b < LAT_NBUCKET - 1){
+      uint64 top = (2UL << b) - 1;
+      return top < h->max ? top : h->max;
+    }
+  }
+  return h->max;
+}
+
+static void
+row(char *name, struct lathist *h)
+{
+  char cnt[24];
+  int n = 0, len = strlen(name);
+  uint64 v = h->count;
+
+  printf("%s", name);
+  for(int i = len; i < 20; i++)
+    fputc(' ', stdout);
+  do
+    cnt[n++] = '0' + v % 10;
+  while((v /= 10) != 0);
+  for(int i = n; i < 9; i++)
+    fputc(' ', stdout);
+  while(n > 0)
+    fputc(cnt[--n], stdout);
+  col(h->sum / h->count, 10);
+  col(percentile(h, 50), 10);
+  col(percentile(h, 99), 10);
+  col(h->max, 10);
+  fputc('\n', stdout);
+}
+
+static void
+report(void)
+{
+  struct lathist h;
+  char buf[24];
+
+  printf("                        count      mean       p50       p99       max\n");
+  for(int id = 0; id < NLAT; id++){
+    if(latency(LAT_GET, id, &h) < 0){
+      fprintf(stderr, "latency: cannot read histogram %d\n", id);
+      exit(1);
+    }
+    if(h.count == 0)
+      continue;
+    if(id <= LAT_SYSCALL)
+      row(what[id], &h);
+    else {
+      int num = id - LAT_SYS(0);
+      strcpy(buf, "  ");
+      strcpy(buf + 2, num < NELEM(sysnames) && sysnames[num] ? sysnames[num] : "?");
+      row(buf, &h);
+    }
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int pid, w;
+
+  if(argc == 2 && strcmp(argv[1], "-on") == 0){
+    if(latency(LAT_START, 0, 0) < 0){
+      fprintf(stderr, "latency: cannot start timing\n");
+      exit(1);
+    }
+    exit(0);
+  }
+  if(argc == 2 && strcmp(argv[1], "-off") == 0){
+    latency(LAT_STOP, 0, 0);
+    exit(0);
+  }
+  if(argc > 1 && argv[1][0] == '-'){
+    fprintf(stderr, "usage: latency [-on | -off | COMMAND [ARGS...]]\n");
+    exit(1);
+  }
+
+  if(argc > 1){
+    if(latency(LAT_START, 0, 0) < 0){
+      fprintf(stderr, "latency: cannot start timing\n");
+      exit(1);
+    }
+    pid = fork();
+    if(pid < 0){
+      fprintf(stderr, "latency: fork failed\n");
+      latency(LAT_STOP, 0, 0);
+      exit(1);
+    }
+    if(pid == 0){
+      exec(argv[1], argv + 1);
+      fprintf(stderr, "latency: exec %s failed\n", argv[1]);
+      exit(1);
+    }
+    while((w = wait(0)) != pid && w >= 0)
+      ;
+    latency(LAT_STOP, 0, 0);
+  }
+  report();
+  exit(0);
+}
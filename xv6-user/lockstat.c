@@ -0,0 +1,63 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "kernel/include/lockstat.h"
+#include "xv6-user/user.h"
+
+// lockstat [-r | command [args...]]
+// print spinlock contention counters, most contended first.
+// -r zeroes them; with a command, zero them, run it and print
+// what it ran into.
+
+#define NSTAT 64
+
+static struct lockstat st[NSTAT];
+
+int
+main(int argc, char *argv[])
+{
+  int n, i, j, pid;
+  struct lockstat tmp;
+
+  if(argc > 1 && strcmp(argv[1], "-r") == 0){
+    lockstat(0, 0);
+    exit(0);
+  }
+  if(argc > 1){
+    lockstat(0, 0);
+    if((pid = fork()) < 0){
+      fprintf(stderr, "lockstat: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      exec(argv[1], argv + 1);
+      fprintf(stderr, "lockstat: exec %s failed\n", argv[1]);
+      exit(1);
+    }
+    wait(0);
+  }
+
+  if((n = lockstat(st, NSTAT)) < 0){
+    fprintf(stderr, "lockstat: failed\n");
+    exit(1);
+  }
+  // Insertion sort by contended acquisitions, then acquisitions.
+  for(i = 1; i < n; i++){
+    tmp = st[i];
+    for(j = i; j > 0 && (st[j-1].ncontended < tmp.ncontended ||
+        (st[j-1].ncontended == tmp.ncontended && st[j-1].nacquire < tmp.nacquire)); j--)
+      st[j] = st[j-1];
+    st[j] = tmp;
+  }
+
+  printf("name\t\tlocks\tacquire\tcontend\tspins\tspin us\tmaxhold us\n");
+  for(i = 0; i < n; i++){
+    if(st[i].nacquire == 0)
+      continue;
+    printf("%s\t%s%d\t%d\t%d\t%d\t%d\t%d\n", st[i].name,
+           strlen(st[i].name) < 8 ? "\t" : "",
+           (int)st[i].nlocks, (int)st[i].nacquire, (int)st[i].ncontended,
+           (int)st[i].nspin, (int)(st[i].spintime * 1000000 / CLK_FREQ),
+           (int)(st[i].maxhold * 1000000 / CLK_FREQ));
+  }
+  exit(0);
+}
@@ -0,0 +1,104 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "xv6-user/user.h"
+
+// mallocbench [-n N]
+// time malloc/free under a few allocation patterns, N objects
+// (default 4096) live at a time, and report operations per second.
+
+#define HZ    (CLK_FREQ / INTERVAL)   // uptime() ticks per second
+#define ROUNDS 16
+
+static void **ptrs;
+static uint seed = 1;
+
+static uint
+rand(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static void
+report(char *name, int t0, int nops)
+{
+  int t1 = uptime();
+
+  if(t1 == t0)
+    t1 = t0 + 1;
+  printf("%s\t%d ops in %d ticks, %d ops/s\n",
+         name, nops, t1 - t0, (int)((uint64)nops * HZ / (t1 - t0)));
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n = 4096, t0, i, r, j;
+  void *tmp;
+
+  if(argc == 3 && strcmp(argv[1], "-n") == 0)
+    n = atoi(argv[2]);
+  else if(argc != 1)
+    goto usage;
+  if(n <= 0)
+    goto usage;
+  if((ptrs = malloc(n * sizeof(void*))) == 0){
+    fprintf(stderr, "mallocbench: out of memory\n");
+    exit(1);
+  }
+
+  // One small object allocated and freed straight away.
+  t0 = uptime();
+  for(i = 0; i < n * ROUNDS; i++)
+    free(malloc(32));
+  report("pair", t0, 2 * n * ROUNDS);
+
+  // n small objects allocated, then freed in the same order.
+  t0 = uptime();
+  for(r = 0; r < ROUNDS; r++){
+    for(i = 0; i < n; i++)
+      ptrs[i] = malloc(16 + i % 100);
+    for(i = 0; i < n; i++)
+      free(ptrs[i]);
+  }
+  report("fifo", t0, 2 * n * ROUNDS);
+
+  // n small objects freed in random order, as a shell or a
+  // parser tearing down its tree would.
+  t0 = uptime();
+  for(r = 0; r < ROUNDS; r++){
+    for(i = 0; i < n; i++)
+      ptrs[i] = malloc(16 + rand() % 200);
+    for(i = n - 1; i > 0; i--){
+      j = rand() % (i + 1);
+      tmp = ptrs[i], ptrs[i] = ptrs[j], ptrs[j] = tmp;
+    }
+    for(i = 0; i < n; i++)
+      free(ptrs[i]);
+  }
+  report("random", t0, 2 * n * ROUNDS);
+
+  // Steady state: replace a random live object, now and then
+  // with a large one.
+  for(i = 0; i < n; i++)
+    ptrs[i] = malloc(64);
+  t0 = uptime();
+  for(i = 0; i < n * ROUNDS; i++){
+    j = rand() % n;
+    free(ptrs[j]);
+    ptrs[j] = malloc(rand() % 64 == 0 ? 4096 + rand() % 8192 : 8 + rand() % 500);
+    if(ptrs[j] == 0){
+      fprintf(stderr, "mallocbench: out of memory\n");
+      exit(1);
+    }
+  }
+  report("mixed", t0, 2 * n * ROUNDS);
+  for(i = 0; i < n; i++)
+    free(ptrs[i]);
+
+  exit(0);
+
+usage:
+  fprintf(stderr, "usage: mallocbench [-n N]\n");
+  exit(1);
+}
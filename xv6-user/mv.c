@@ -7,7 +7,7 @@
 int main(int argc, char *argv[])
 {
     if (argc < 3) {
-        fprintf(2, "Usage: mv old_name new_name\n");
+        fprintf(stderr, "Usage: mv old_name new_name\n");
         exit(1);
     }
 
@@ -35,18 +35,18 @@ int main(int argc, char *argv[])
             while (*ps) {
                 *pd++ = *ps++;
                 if (pd >= dst + MAXPATH) {
-                    fprintf(2, "mv: fail! final dst path too long (exceed MAX=%d)!\n", MAXPATH);
+                    fprintf(stderr, "mv: fail! final dst path too long (exceed MAX=%d)!\n", MAXPATH);
                     exit(-1);
                 }
             }
         } else {
-            fprintf(2, "mv: fail! %s exists!\n", dst);
+            fprintf(stderr, "mv: fail! %s exists!\n", dst);
             exit(-1);
         }
     }
     printf("moving [%s] to [%s]\n", src, dst);
     if (rename(src, dst) < 0) {
-        fprintf(2, "mv: fail to rename %s to %s!\n", src, dst);
+        fprintf(stderr, "mv: fail to rename %s to %s!\n", src, dst);
         exit(-1);
     }
     exit(0);
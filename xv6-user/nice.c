@@ -0,0 +1,41 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "kernel/include/sched.h"
+#include "xv6-user/user.h"
+
+// nice [-n NICE] [-b] COMMAND [ARG]...
+// run COMMAND with the given nice value (default 10),
+// in the batch scheduling class if -b is given.
+int
+main(int argc, char *argv[])
+{
+  int nice = 10, batch = 0;
+  int i;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+      nice = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "-b") == 0){
+      batch = 1;
+    } else {
+      break;
+    }
+  }
+  if(i >= argc){
+    fprintf(stderr, "usage: nice [-n NICE] [-b] COMMAND [ARG]...\n");
+    exit(1);
+  }
+
+  if(setpriority(0, nice) < 0){
+    fprintf(stderr, "nice: bad nice value %d, should be %d..%d\n", nice, NICE_MIN, NICE_MAX);
+    exit(1);
+  }
+  if(batch && setscheduler(0, SCHED_BATCH) < 0){
+    fprintf(stderr, "nice: setscheduler failed\n");
+    exit(1);
+  }
+
+  exec(argv[i], argv + i);
+  fprintf(stderr, "nice: exec %s failed\n", argv[i]);
+  exit(1);
+}
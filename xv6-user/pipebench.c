@@ -0,0 +1,83 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "kernel/include/fcntl.h"
+#include "xv6-user/user.h"
+
+// pipebench [-s PIPESZ] [-b BLOCK] [-m MB]
+// push MB megabytes (default 4) through a pipe to a child,
+// BLOCK bytes (default 4096) per write, and report throughput.
+// -s resizes the pipe first with F_SETPIPE_SZ.
+
+#define HZ  (CLK_FREQ / INTERVAL)   // uptime() ticks per second
+
+static char buf[65536];
+
+int
+main(int argc, char *argv[])
+{
+  int fds[2], pid, n, size = 0, block = 4096, mb = 4, cap;
+  uint64 total, done;
+  int t0, t1;
+
+  for(int i = 1; i + 1 < argc; i += 2){
+    if(strcmp(argv[i], "-s") == 0)
+      size = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-b") == 0)
+      block = atoi(argv[i + 1]);
+    else if(strcmp(argv[i], "-m") == 0)
+      mb = atoi(argv[i + 1]);
+    else
+      goto usage;
+  }
+  if(block <= 0 || block > sizeof(buf) || mb <= 0)
+    goto usage;
+
+  if(pipe(fds) < 0){
+    fprintf(stderr, "pipebench: pipe failed\n");
+    exit(1);
+  }
+  if(size > 0 && fcntl(fds[1], F_SETPIPE_SZ, size) < 0){
+    fprintf(stderr, "pipebench: cannot resize pipe to %d\n", size);
+    exit(1);
+  }
+  cap = fcntl(fds[1], F_GETPIPE_SZ, 0);
+  total = (uint64)mb << 20;
+
+  pid = fork();
+  if(pid < 0){
+    fprintf(stderr, "pipebench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    close(fds[1]);
+    while(read(fds[0], buf, sizeof(buf)) > 0)
+      ;
+    exit(0);
+  }
+
+  close(fds[0]);
+  t0 = uptime();
+  for(done = 0; done < total; done += n){
+    n = block;
+    if(n > total - done)
+      n = total - done;
+    if(write(fds[1], buf, n) != n){
+      fprintf(stderr, "pipebench: write failed\n");
+      exit(1);
+    }
+  }
+  close(fds[1]);
+  wait(0);
+  t1 = uptime();
+
+  if(t1 == t0)
+    t1 = t0 + 1;
+  printf("pipe %d bytes, block %d: %d KB in %d ticks, %d KB/s\n",
+         cap, block,
+         (int)(total >> 10), t1 - t0, (int)((total >> 10) * HZ / (t1 - t0)));
+  exit(0);
+
+usage:
+  fprintf(stderr, "usage: pipebench [-s PIPESZ] [-b BLOCK] [-m MB]\n");
+  exit(1);
+}
@@ -0,0 +1,105 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "kernel/include/prof.h"
+#include "xv6-user/user.h"
+
+// prof [-o FILE] COMMAND [ARGS...]
+// run COMMAND with the sampling profiler on, and write every
+// sample taken on any hart meanwhile to FILE (default prof.out),
+// one per line:
+//   k|u hart pid name pc
+// Copy FILE off the image and run tools/profsym.py on it to get
+// a flat profile by function, kernel and user.
+
+#define NBATCH  256
+
+static struct profsample batch[NBATCH];
+static FILE *out;
+static int nsample;
+static volatile int done;
+static char stack[4096];
+
+static int
+drain(void)
+{
+  int n, total = 0;
+
+  while((n = prof(PROF_READ, batch, NBATCH)) > 0){
+    for(int i = 0; i < n; i++){
+      struct profsample *s = &batch[i];
+      fprintf(out, "%s %d %d %s %p\n", s->user ? "u" : "k",
+              s->cpu, s->pid, s->name, s->pc);
+    }
+    total += n;
+  }
+  nsample += total;
+  return total;
+}
+
+// The writer thread: keep the kernel's rings from filling up.
+static void
+writer(void *unused)
+{
+  int last = 0;
+
+  while(!last){
+    last = done;
+    if(drain() == 0 && !last)
+      nanosleep(50 * 1000 * 1000);
+  }
+  exit(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char *path = "prof.out";
+  int i = 1, pid, w, dropped;
+
+  if(argc > 2 && strcmp(argv[1], "-o") == 0){
+    path = argv[2];
+    i = 3;
+  }
+  if(i >= argc){
+    fprintf(stderr, "usage: prof [-o FILE] COMMAND [ARGS...]\n");
+    exit(1);
+  }
+  if((out = fopen(path, "w")) == 0){
+    fprintf(stderr, "prof: cannot create %s\n", path);
+    exit(1);
+  }
+
+  if(prof(PROF_START, 0, 0) < 0){
+    fprintf(stderr, "prof: cannot start profiling\n");
+    exit(1);
+  }
+  pid = fork();
+  if(pid < 0){
+    fprintf(stderr, "prof: fork failed\n");
+    prof(PROF_STOP, 0, 0);
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[i], argv + i);
+    fprintf(stderr, "prof: exec %s failed\n", argv[i]);
+    exit(1);
+  }
+
+  if(clone(writer, 0, stack + sizeof(stack)) < 0){
+    fprintf(stderr, "prof: clone failed\n");
+    kill(pid);
+    prof(PROF_STOP, 0, 0);
+    exit(1);
+  }
+  while((w = wait(0)) != pid && w >= 0)
+    ;
+  dropped = prof(PROF_STOP, 0, 0);
+  done = 1;
+  wait(0);          // the writer
+  fclose(out);
+  fprintf(stderr, "prof: %d samples in %s", nsample, path);
+  if(dropped > 0)
+    fprintf(stderr, ", %d dropped", dropped);
+  fprintf(stderr, "\n");
+  exit(0);
+}
@@ -9,13 +9,13 @@ main(int argc, char *argv[])
   int i;
 
   if(argc < 2){
-    fprintf(2, "Usage: rm files...\n");
+    fprintf(stderr, "Usage: rm files...\n");
     exit(1);
   }
 
   for(i = 1; i < argc; i++){
     if(remove(argv[i]) < 0){
-      fprintf(2, "rm: %s failed to delete\n", argv[i]);
+      fprintf(stderr, "rm: %s failed to delete\n", argv[i]);
     }
   }
 
@@ -98,7 +98,7 @@ export(char *argv[])
   }
   else if(nenv == NENVS)
   {
-    fprintf(2, "too many env vars\n");
+    fprintf(stderr, "too many env vars\n");
     return -1;
   }
   char name[32], value[96];
@@ -110,7 +110,7 @@ export(char *argv[])
 
   if(checkenvname(name) != ((s - argv[1]) - 1))
   {
-    fprintf(2, "Invalid NAME!\n");
+    fprintf(stderr, "Invalid NAME!\n");
     return -1;
   }
   for(t=value; (*t=*s); s++, t++)
@@ -192,14 +192,14 @@ runcmd(struct cmd *cmd)
 
       exec(env_cmd, ecmd->argv);
     }
-    fprintf(2, "exec %s failed\n", ecmd->argv[0]);
+    fprintf(stderr, "exec %s failed\n", ecmd->argv[0]);
     break;
 
   case REDIR:
     rcmd = (struct redircmd*)cmd;
     close(rcmd->fd);
     if(open(rcmd->file, rcmd->mode) < 0){
-      fprintf(2, "open %s failed\n", rcmd->file);
+      fprintf(stderr, "open %s failed\n", rcmd->file);
       exit(1);
     }
     runcmd(rcmd->cmd);
@@ -249,7 +249,7 @@ runcmd(struct cmd *cmd)
 int
 getcmd(char *buf, int nbuf)
 {
-  fprintf(2, "-> %s $ ", mycwd);
+  fprintf(stderr, "-> %s $ ", mycwd);
   memset(buf, 0, nbuf);
   gets(buf, nbuf);
   if(buf[0] == 0) // EOF
@@ -284,7 +284,7 @@ main(void)
       // Chdir must be called by the parent, not the child.
       buf[strlen(buf)-1] = 0;  // chop \n
       if(chdir(buf+3) < 0)
-        fprintf(2, "cannot cd %s\n", buf+3);
+        fprintf(stderr, "cannot cd %s\n", buf+3);
       getcwd(mycwd);
     }
     else{
@@ -300,9 +300,9 @@ main(void)
       {
         // Export must be called by the parent, not the child.
         if(ecmd->argv[1] == NULL)
-          fprintf(2, "Usage: export [-p] [NAME=VALUE]\n");
+          fprintf(stderr, "Usage: export [-p] [NAME=VALUE]\n");
         else if(export(ecmd->argv) < 0)
-          fprintf(2, "export failed\n");
+          fprintf(stderr, "export failed\n");
         free(cmd);
         continue;
       }
@@ -318,7 +318,7 @@ main(void)
 void
 panic(char *s)
 {
-  fprintf(2, "%s\n", s);
+  fprintf(stderr, "%s\n", s);
   exit(1);
 }
 
@@ -478,7 +478,7 @@ parsecmd(char *s)
   cmd = parseline(&s, es);
   peek(&s, es, "");
   if(s != es){
-    fprintf(2, "leftovers: %s\n", s);
+    fprintf(stderr, "leftovers: %s\n", s);
     panic("syntax");
   }
   nulterminate(cmd);
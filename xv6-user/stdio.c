@@ -0,0 +1,358 @@
+#include "kernel/include/types.h"
+#include "kernel/include/stat.h"
+#include "kernel/include/fcntl.h"
+#include "xv6-user/user.h"
+
+// Buffered streams over file descriptors.
+//
+// A stream either reads or writes. Output is kept in the
+// stream's buffer until it fills, until a newline on a
+// line-buffered stream, or until fflush(); an unbuffered
+// stream still gathers each call's output into one write().
+// stdout is line-buffered on the console and fully buffered
+// otherwise; stderr is unbuffered. fork(), exec() and exit()
+// flush every stream, so output is neither lost nor doubled.
+
+static char inbuf[BUFSIZ], outbuf[BUFSIZ], errbuf[BUFSIZ];
+
+static FILE iob[3] = {
+  { .fd = 0, .flags = F_READ,  .mode = _IOFBF,  .buf = inbuf,  .size = BUFSIZ },
+  { .fd = 1, .flags = F_WRITE, .mode = _IOAUTO, .buf = outbuf, .size = BUFSIZ },
+  { .fd = 2, .flags = F_WRITE, .mode = _IONBF,  .buf = errbuf, .size = BUFSIZ },
+};
+
+FILE *stdin = &iob[0];
+FILE *stdout = &iob[1];
+FILE *stderr = &iob[2];
+
+// Streams from fopen()/fdopen(), for fflush(0).
+static FILE *streams;
+
+// Pick stdout's mode on first use, once we know what fd 1 is.
+static void
+automode(FILE *f)
+{
+  struct stat st;
+
+  if(fstat(f->fd, &st) == 0 && st.type == T_DEVICE)
+    f->mode = _IOLBF;
+  else
+    f->mode = _IOFBF;
+}
+
+static int
+flushbuf(FILE *f)
+{
+  int off, n;
+
+  for(off = 0; off < f->pos; off += n){
+    if((n = write(f->fd, f->buf + off, f->pos - off)) <= 0){
+      f->flags |= F_ERR;
+      f->pos = 0;
+      return EOF;
+    }
+  }
+  f->pos = 0;
+  return 0;
+}
+
+int
+fflush(FILE *f)
+{
+  int r = 0;
+
+  if(f == 0){
+    for(int i = 0; i < NELEM(iob); i++)
+      if(fflush(&iob[i]) < 0)
+        r = EOF;
+    for(f = streams; f; f = f->next)
+      if(fflush(f) < 0)
+        r = EOF;
+    return r;
+  }
+  if(f->flags & F_WRITE)
+    return flushbuf(f);
+  return 0;
+}
+
+int
+fputc(int c, FILE *f)
+{
+  if(!(f->flags & F_WRITE))
+    return EOF;
+  if(f->mode == _IOAUTO)
+    automode(f);
+  if(f->pos == f->size && flushbuf(f) < 0)
+    return EOF;
+  f->buf[f->pos++] = c;
+  if((f->mode == _IOLBF && c == '\n') || f->mode == _IONBF)
+    if(flushbuf(f) < 0)
+      return EOF;
+  return (uchar)c;
+}
+
+uint
+fwrite(const void *buf, uint size, uint n, FILE *f)
+{
+  const char *p = buf;
+  uint total = size * n, done, m;
+  int r;
+
+  if(!(f->flags & F_WRITE) || total == 0)
+    return 0;
+  if(f->mode == _IOAUTO)
+    automode(f);
+
+  // Too big to be worth copying: write it straight out.
+  if(total >= f->size){
+    if(flushbuf(f) < 0)
+      return 0;
+    for(done = 0; done < total; done += r)
+      if((r = write(f->fd, p + done, total - done)) <= 0){
+        f->flags |= F_ERR;
+        return done / size;
+      }
+    return n;
+  }
+
+  for(done = 0; done < total; done += m){
+    if(f->pos == f->size && flushbuf(f) < 0)
+      return done / size;
+    m = total - done;
+    if(m > f->size - f->pos)
+      m = f->size - f->pos;
+    memmove(f->buf + f->pos, p + done, m);
+    f->pos += m;
+  }
+  if(f->mode == _IONBF)
+    flushbuf(f);
+  else if(f->mode == _IOLBF){
+    for(done = 0; done < total; done++)
+      if(p[done] == '\n'){
+        flushbuf(f);
+        break;
+      }
+  }
+  return n;
+}
+
+int
+fputs(const char *s, FILE *f)
+{
+  uint n = strlen(s);
+
+  if(fwrite(s, 1, n, f) != n)
+    return EOF;
+  return 0;
+}
+
+static int
+fill(FILE *f)
+{
+  int n;
+
+  if(!(f->flags & F_READ) || (f->flags & (F_EOF | F_ERR)))
+    return EOF;
+  // As in C: reading flushes interactive output first, so that
+  // a prompt shows up before we block.
+  if(stdout->mode == _IOLBF)
+    flushbuf(stdout);
+  n = read(f->fd, f->buf, f->size);
+  if(n <= 0){
+    f->flags |= n == 0 ? F_EOF : F_ERR;
+    return EOF;
+  }
+  f->pos = 0;
+  f->len = n;
+  return 0;
+}
+
+int
+fgetc(FILE *f)
+{
+  if(f->pos == f->len && fill(f) < 0)
+    return EOF;
+  return (uchar)f->buf[f->pos++];
+}
+
+uint
+fread(void *buf, uint size, uint n, FILE *f)
+{
+  char *p = buf;
+  uint total = size * n, done = 0, m;
+  int r;
+
+  if(total == 0)
+    return 0;
+  while(done < total){
+    if(f->pos == f->len){
+      // Big reads go straight into the caller's buffer.
+      if(total - done >= f->size && (f->flags & F_READ)
+         && !(f->flags & (F_EOF | F_ERR))){
+        if(stdout->mode == _IOLBF)
+          flushbuf(stdout);
+        if((r = read(f->fd, p + done, total - done)) <= 0){
+          f->flags |= r == 0 ? F_EOF : F_ERR;
+          break;
+        }
+        done += r;
+        continue;
+      }
+      if(fill(f) < 0)
+        break;
+    }
+    m = f->len - f->pos;
+    if(m > total - done)
+      m = total - done;
+    memmove(p + done, f->buf + f->pos, m);
+    f->pos += m;
+    done += m;
+  }
+  return done / size;
+}
+
+char*
+fgets(char *buf, int max, FILE *f)
+{
+  int i, c;
+
+  for(i = 0; i + 1 < max; ){
+    if((c = fgetc(f)) == EOF)
+      break;
+    buf[i++] = c;
+    if(c == '\n')
+      break;
+  }
+  if(i == 0)
+    return 0;
+  buf[i] = '\0';
+  return buf;
+}
+
+int
+feof(FILE *f)
+{
+  return (f->flags & F_EOF) != 0;
+}
+
+int
+ferror(FILE *f)
+{
+  return (f->flags & F_ERR) != 0;
+}
+
+// Must be called before any I/O on f. If buf is 0, a buffer
+// of the given size is allocated.
+int
+setvbuf(FILE *f, char *buf, int mode, uint size)
+{
+  if(mode != _IONBF && mode != _IOLBF && mode != _IOFBF)
+    return -1;
+  if(size > 0){
+    if(buf == 0 && (buf = malloc(size)) == 0)
+      return -1;
+    if(f->flags & F_OWNBUF)
+      free(f->buf);
+    f->flags &= ~F_OWNBUF;
+    f->buf = buf;
+    f->size = size;
+  }
+  f->mode = mode;
+  return 0;
+}
+
+FILE*
+fdopen(int fd, const char *mode)
+{
+  FILE *f;
+
+  if(fd < 0 || (f = malloc(sizeof(*f))) == 0)
+    return 0;
+  if((f->buf = malloc(BUFSIZ)) == 0){
+    free(f);
+    return 0;
+  }
+  f->fd = fd;
+  f->flags = (mode[0] == 'r' ? F_READ : F_WRITE) | F_OWNBUF;
+  f->mode = _IOFBF;
+  f->size = BUFSIZ;
+  f->pos = f->len = 0;
+  f->next = streams;
+  streams = f;
+  return f;
+}
+
+// mode is "r", "w" or "a".
+FILE*
+fopen(const char *path, const char *mode)
+{
+  int fd, omode;
+  FILE *f;
+
+  switch(mode[0]){
+  case 'r':
+    omode = O_RDONLY;
+    break;
+  case 'w':
+    omode = O_WRONLY | O_CREATE | O_TRUNC;
+    break;
+  case 'a':
+    omode = O_WRONLY | O_CREATE | O_APPEND;
+    break;
+  default:
+    return 0;
+  }
+  if((fd = open(path, omode)) < 0)
+    return 0;
+  if((f = fdopen(fd, mode)) == 0)
+    close(fd);
+  return f;
+}
+
+int
+fclose(FILE *f)
+{
+  FILE **pp;
+  int r;
+
+  r = fflush(f);
+  if(close(f->fd) < 0)
+    r = EOF;
+  if(f >= iob && f < iob + NELEM(iob)){
+    f->flags &= ~(F_READ | F_WRITE);
+    return r;
+  }
+  for(pp = &streams; *pp; pp = &(*pp)->next)
+    if(*pp == f){
+      *pp = f->next;
+      break;
+    }
+  if(f->flags & F_OWNBUF)
+    free(f->buf);
+  free(f);
+  return r;
+}
+
+// The syscall stubs are _fork, _exec and _exit; these wrap
+// them so that no buffered output is copied, lost or left behind.
+
+int
+fork(void)
+{
+  fflush(0);
+  return _fork();
+}
+
+int
+exec(char *path, char **argv)
+{
+  fflush(0);
+  return _exec(path, argv);
+}
+
+int
+exit(int status)
+{
+  fflush(0);
+  _exit(status);
+}
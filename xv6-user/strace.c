@@ -1,28 +1,154 @@
 #include "kernel/include/param.h"
 #include "kernel/include/types.h"
 #include "kernel/include/stat.h"
+#include "kernel/include/sysnum.h"
+#include "kernel/include/trace.h"
 #include "xv6-user/user.h"
+#include "xv6-user/sysnames.h"
+
+// strace [-m MASK] COMMAND [ARGS...]
+// run COMMAND with the system calls in MASK (default all) traced,
+// and print them as they complete:
+//   time(us) hart pid name(a0, a1, a2) = ret <duration us>
+// The kernel logs calls into per-hart rings without printing;
+// a thread here reads the rings while the main thread waits for
+// COMMAND, so tracing costs the traced program very little.
+
+#define NBATCH  (2 * TRACE_NREC)
+
+static struct tracerec batch[NBATCH];
+static uint64 next[NCPU];   // next seq to read, per hart
+static uint64 tstart;
+static volatile int done;
+static char stack[4096];
+
+// Read everything new from every hart into batch.
+static int
+collect(void)
+{
+  int cpu, n, got, total = 0;
+
+  for(cpu = 0; cpu < NCPU; cpu++){
+    while(total < NBATCH &&
+          (got = traceread(cpu, next[cpu], batch + total, NBATCH - total)) > 0){
+      if(batch[total].seq > next[cpu])
+        fprintf(stderr, "strace: hart %d: %d records lost\n",
+                cpu, (int)(batch[total].seq - next[cpu]));
+      next[cpu] = batch[total + got - 1].seq + 1;
+      total += got;
+    }
+    if(total == NBATCH)
+      break;
+  }
+  // Interleave the harts by entry time.
+  for(int i = 1; i < total; i++){
+    struct tracerec r = batch[i];
+    for(n = i; n > 0 && batch[n-1].tenter > r.tenter; n--)
+      batch[n] = batch[n-1];
+    batch[n] = r;
+  }
+  return total;
+}
+
+static uint64
+us(uint64 t)
+{
+  return t * 1000000 / CLK_FREQ;
+}
+
+static void
+arg(uint64 v)
+{
+  if((long)v > -100000 && (long)v < 1000000)
+    printf("%d", (int)v);
+  else
+    printf("%p", v);
+}
+
+static void
+show(struct tracerec *r)
+{
+  if(tstart == 0)
+    tstart = r->tenter;
+  printf("%d %d %d ", (int)us(r->tenter - tstart), r->cpu, r->pid);
+  if(r->num > 0 && r->num < NELEM(sysnames) && sysnames[r->num])
+    printf("%s(", sysnames[r->num]);
+  else
+    printf("syscall%d(", r->num);
+  for(int i = 0; i < 3; i++){
+    arg(r->args[i]);
+    printf(i < 2 ? ", " : ")");
+  }
+  if(r->num == SYS_exit)
+    printf("\n");
+  else {
+    printf(" = ");
+    arg(r->ret);
+    printf(" <%d>\n", (int)us(r->texit - r->tenter));
+  }
+}
+
+// The reader thread: print records until the command is done,
+// then once more to catch the last of them.
+static void
+reader(void *unused)
+{
+  int n, last = 0;
+
+  while(!last){
+    last = done;
+    n = collect();
+    for(int i = 0; i < n; i++)
+      show(&batch[i]);
+    fflush(stdout);
+    if(n == 0 && !last)
+      nanosleep(10 * 1000 * 1000);
+  }
+  exit(0);
+}
 
 int
 main(int argc, char *argv[])
 {
-  int i;
-  char *nargv[MAXARG];
+  int i = 1, pid, w;
+  uint64 mask = ~0UL;
 
-  if(argc < 3 /*|| (argv[1][0] < '0' || argv[1][0] > '9')*/){
-    fprintf(2, "usage: %s MASK COMMAND\n", argv[0]);
+  if(argc > 2 && strcmp(argv[1], "-m") == 0){
+    mask = atoi(argv[2]);
+    i = 3;
+  }
+  if(i >= argc){
+    fprintf(stderr, "usage: strace [-m MASK] COMMAND [ARGS...]\n");
     exit(1);
   }
 
-  if (trace(atoi(argv[1])) < 0) {
-    fprintf(2, "%s: strace failed\n", argv[0]);
+  // Skip whatever earlier tracing left in the rings.
+  while(collect() > 0)
+    ;
+
+  pid = fork();
+  if(pid < 0){
+    fprintf(stderr, "strace: fork failed\n");
     exit(1);
   }
-  
-  for(i = 2; i < argc && i < MAXARG; i++){
-    nargv[i-2] = argv[i];
+  if(pid == 0){
+    if(trace(mask) < 0){
+      fprintf(stderr, "strace: trace failed\n");
+      exit(1);
+    }
+    exec(argv[i], argv + i);
+    fprintf(stderr, "strace: exec %s failed\n", argv[i]);
+    exit(1);
+  }
+
+  if(clone(reader, 0, stack + sizeof(stack)) < 0){
+    fprintf(stderr, "strace: clone failed\n");
+    kill(pid);
+    exit(1);
   }
-  exec(nargv[0], nargv);  
-  printf("strace: exec %s fail\n", nargv[0]);
+  while((w = wait(0)) != pid && w >= 0)
+    ;
+  done = 1;
+  wait(0);          // the reader
   exit(0);
 }
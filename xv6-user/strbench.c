@@ -0,0 +1,152 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "xv6-user/user.h"
+
+// strbench [-m MB]
+// run the ulib string and memory routines over MB megabytes
+// (default 16) of buffers of each size, next to the plain
+// byte loops they replaced, and report throughput in KB/s.
+
+#define HZ    (CLK_FREQ / INTERVAL)   // uptime() ticks per second
+#define BUFSZ 65536
+
+static char src[BUFSZ + 16], dst[BUFSZ + 16];
+static int sizes[] = { 8, 64, 512, 4096, BUFSZ };
+
+// The byte-at-a-time versions, for comparison.
+
+static void*
+bmemset(void *dst, int c, uint n)
+{
+  char *cdst = (char *) dst;
+  for(int i = 0; i < n; i++)
+    cdst[i] = c;
+  return dst;
+}
+
+static void*
+bmemmove(void *vdst, const void *vsrc, int n)
+{
+  char *d = vdst;
+  const char *s = vsrc;
+  while(n-- > 0)
+    *d++ = *s++;
+  return vdst;
+}
+
+static int
+bmemcmp(const void *s1, const void *s2, uint n)
+{
+  const uchar *p1 = s1, *p2 = s2;
+  for(; n > 0; n--, p1++, p2++)
+    if(*p1 != *p2)
+      return *p1 - *p2;
+  return 0;
+}
+
+static uint
+bstrlen(const char *s)
+{
+  int n;
+  for(n = 0; s[n]; n++)
+    ;
+  return n;
+}
+
+static char*
+bstrchr(const char *s, char c)
+{
+  for(; *s; s++)
+    if(*s == c)
+      return (char*)s;
+  return 0;
+}
+
+static int
+bstrcmp(const char *p, const char *q)
+{
+  while(*p && *p == *q)
+    p++, q++;
+  return (uchar)*p - (uchar)*q;
+}
+
+enum { MEMSET, MEMMOVE, MEMCMP, STRLEN, STRCHR, STRCMP, NOPS };
+static char *opnames[] = {
+  "memset", "memmove", "memcmp", "strlen", "strchr", "strcmp",
+};
+
+volatile uint64 sink;
+
+// Run op with the old (byte) or new (ulib) routine on n-byte
+// buffers until total bytes have gone by; return KB/s.
+static int
+run(int op, int old, int n, uint64 total)
+{
+  uint64 done;
+  int t0, t1, len = n - 1;
+
+  // Strings: n-1 non-NUL bytes, identical in both buffers,
+  // searched for a byte that is not there.
+  memset(src, 'a', n);
+  src[len] = 0;
+  memmove(dst, src, n);
+
+  t0 = uptime();
+  for(done = 0; done < total; done += n){
+    switch(op){
+    case MEMSET:
+      old ? bmemset(dst, done, n) : memset(dst, done, n);
+      break;
+    case MEMMOVE:
+      old ? bmemmove(dst, src, n) : memmove(dst, src, n);
+      break;
+    case MEMCMP:
+      sink += old ? bmemcmp(dst, src, n) : memcmp(dst, src, n);
+      break;
+    case STRLEN:
+      sink += old ? bstrlen(src) : strlen(src);
+      break;
+    case STRCHR:
+      sink += (uint64)(old ? bstrchr(src, 'z') : strchr(src, 'z'));
+      break;
+    case STRCMP:
+      sink += old ? bstrcmp(dst, src) : strcmp(dst, src);
+      break;
+    }
+  }
+  t1 = uptime();
+  if(t1 == t0)
+    t1 = t0 + 1;
+  return (total >> 10) * HZ / (t1 - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int mb = 16;
+  uint64 total;
+
+  if(argc == 3 && strcmp(argv[1], "-m") == 0)
+    mb = atoi(argv[2]);
+  else if(argc != 1)
+    goto usage;
+  if(mb <= 0)
+    goto usage;
+  total = (uint64)mb << 20;
+
+  printf("%d MB per run, KB/s as byte loop -> ulib\n", mb);
+  printf("op      ");
+  for(int i = 0; i < NELEM(sizes); i++)
+    printf("%d%s", sizes[i], i + 1 < NELEM(sizes) ? "\t\t" : "\n");
+  for(int op = 0; op < NOPS; op++){
+    printf("%s\t", opnames[op]);
+    for(int i = 0; i < NELEM(sizes); i++)
+      printf("%d->%d%s", run(op, 1, sizes[i], total), run(op, 0, sizes[i], total),
+             i + 1 < NELEM(sizes) ? "\t" : "\n");
+  }
+  exit(0);
+
+usage:
+  fprintf(stderr, "usage: strbench [-m MB]\n");
+  exit(1);
+}
@@ -0,0 +1,54 @@
+#ifndef __SYSNAMES_H
+#define __SYSNAMES_H
+
+// System call names by number, for strace and latency.
+// Include after kernel/include/sysnum.h.
+
+static char *sysnames[] = {
+  [SYS_fork]        "fork",
+  [SYS_exit]        "exit",
+  [SYS_wait]        "wait",
+  [SYS_pipe]        "pipe",
+  [SYS_read]        "read",
+  [SYS_kill]        "kill",
+  [SYS_exec]        "exec",
+  [SYS_fstat]       "fstat",
+  [SYS_chdir]       "chdir",
+  [SYS_dup]         "dup",
+  [SYS_getpid]      "getpid",
+  [SYS_sbrk]        "sbrk",
+  [SYS_sleep]       "sleep",
+  [SYS_uptime]      "uptime",
+  [SYS_open]        "open",
+  [SYS_write]       "write",
+  [SYS_mkdir]       "mkdir",
+  [SYS_close]       "close",
+  [SYS_test_proc]   "test_proc",
+  [SYS_dev]         "dev",
+  [SYS_readdir]     "readdir",
+  [SYS_getcwd]      "getcwd",
+  [SYS_remove]      "remove",
+  [SYS_trace]       "trace",
+  [SYS_sysinfo]     "sysinfo",
+  [SYS_rename]      "rename",
+  [SYS_nanosleep]   "nanosleep",
+  [SYS_setpriority] "setpriority",
+  [SYS_setscheduler] "setscheduler",
+  [SYS_sched_setaffinity] "sched_setaffinity",
+  [SYS_sched_getaffinity] "sched_getaffinity",
+  [SYS_clone]       "clone",
+  [SYS_futex]       "futex",
+  [SYS_fcntl]       "fcntl",
+  [SYS_splice]      "splice",
+  [SYS_tee]         "tee",
+  [SYS_lockstat]    "lockstat",
+  [SYS_cpustat]     "cpustat",
+  [SYS_traceread]   "traceread",
+  [SYS_prof]        "prof",
+  [SYS_latency]     "latency",
+  [SYS_lseek]       "lseek",
+  [SYS_rdtime]      "rdtime",
+  [SYS_sched_yield] "sched_yield",
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "xv6-user/user.h"
+
+// taskset MASK COMMAND [ARG]...   run COMMAND on the harts in MASK
+// taskset -p MASK PID             move a running process
+// taskset -p PID                  print the hart mask of a process
+int
+main(int argc, char *argv[])
+{
+  if(argc >= 3 && strcmp(argv[1], "-p") == 0){
+    if(argc == 3){
+      int pid = atoi(argv[2]);
+      uint64 mask = sched_getaffinity(pid);
+      if(mask == (uint64)-1){
+        fprintf(stderr, "taskset: no process %d\n", pid);
+        exit(1);
+      }
+      printf("pid %d's affinity mask: %x\n", pid, (int)mask);
+      exit(0);
+    }
+    if(sched_setaffinity(atoi(argv[3]), atoi(argv[2])) < 0){
+      fprintf(stderr, "taskset: failed to set affinity of %s\n", argv[3]);
+      exit(1);
+    }
+    exit(0);
+  }
+
+  if(argc < 3){
+    fprintf(stderr, "usage: taskset MASK COMMAND [ARG]...\n");
+    fprintf(stderr, "       taskset -p [MASK] PID\n");
+    exit(1);
+  }
+  if(sched_setaffinity(0, atoi(argv[1])) < 0){
+    fprintf(stderr, "taskset: bad mask %s\n", argv[1]);
+    exit(1);
+  }
+  exec(argv[2], argv + 2);
+  fprintf(stderr, "taskset: exec %s failed\n", argv[2]);
+  exit(1);
+}
@@ -26,9 +26,27 @@ strcat(char *s, const char *t)
 }
 
 
+// Word-at-a-time helpers. A word is only ever read from an
+// aligned address, so it never straddles a page boundary and
+// reading past the terminating NUL cannot fault.
+#define WSIZE       sizeof(uint64)
+#define WMASK       (WSIZE - 1)
+#define ONES        0x0101010101010101UL
+#define HIGHS       0x8080808080808080UL
+#define HASZERO(w)  (((w) - ONES) & ~(w) & HIGHS)
+
 int
 strcmp(const char *p, const char *q)
 {
+  if(((uint64)p & WMASK) == ((uint64)q & WMASK)){
+    while(((uint64)p & WMASK) != 0){
+      if(*p == 0 || *p != *q)
+        return (uchar)*p - (uchar)*q;
+      p++, q++;
+    }
+    while(*(uint64*)p == *(uint64*)q && !HASZERO(*(uint64*)p))
+      p += WSIZE, q += WSIZE;
+  }
   while(*p && *p == *q)
     p++, q++;
   return (uchar)*p - (uchar)*q;
@@ -37,28 +55,58 @@ strcmp(const char *p, const char *q)
 uint
 strlen(const char *s)
 {
-  int n;
+  const char *p = s;
+  const uint64 *w;
 
-  for(n = 0; s[n]; n++)
+  for(; ((uint64)p & WMASK) != 0; p++)
+    if(*p == 0)
+      return p - s;
+  for(w = (const uint64*)p; !HASZERO(*w); w++)
+    ;
+  for(p = (const char*)w; *p; p++)
     ;
-  return n;
+  return p - s;
 }
 
 void*
 memset(void *dst, int c, uint n)
 {
   char *cdst = (char *) dst;
-  int i;
-  for(i = 0; i < n; i++){
-    cdst[i] = c;
+  uint64 *wdst, w;
+
+  if(n >= 2 * WSIZE){
+    w = (uchar)c * ONES;
+    for(; ((uint64)cdst & WMASK) != 0; n--)
+      *cdst++ = c;
+    wdst = (uint64*)cdst;
+    for(; n >= 4 * WSIZE; n -= 4 * WSIZE, wdst += 4){
+      wdst[0] = w; wdst[1] = w; wdst[2] = w; wdst[3] = w;
+    }
+    for(; n >= WSIZE; n -= WSIZE)
+      *wdst++ = w;
+    cdst = (char*)wdst;
   }
+  while(n-- > 0)
+    *cdst++ = c;
   return dst;
 }
 
 char*
 strchr(const char *s, char c)
 {
-  for(; *s; s++)
+  const uint64 *w;
+  uint64 cw = (uchar)c * ONES;
+
+  for(; ((uint64)s & WMASK) != 0; s++){
+    if(*s == 0)
+      return 0;
+    if(*s == c)
+      return (char*)s;
+  }
+  // stop at the first word holding either c or the NUL.
+  for(w = (const uint64*)s; !HASZERO(*w) && !HASZERO(*w ^ cw); w++)
+    ;
+  for(s = (const char*)w; *s; s++)
     if(*s == c)
       return (char*)s;
   return 0;
@@ -116,15 +164,45 @@ memmove(void *vdst, const void *vsrc, int n)
 {
   char *dst;
   const char *src;
+  uint64 *wdst;
+  const uint64 *wsrc;
+  int aligned;
 
   dst = vdst;
   src = vsrc;
+  // k210 traps misaligned word accesses; only go wide when
+  // both pointers can reach alignment together.
+  aligned = ((uint64)src & WMASK) == ((uint64)dst & WMASK);
   if (src > dst) {
+    if(aligned){
+      for(; n > 0 && ((uint64)dst & WMASK) != 0; n--)
+        *dst++ = *src++;
+      wdst = (uint64*)dst;
+      wsrc = (const uint64*)src;
+      for(; n >= 4 * WSIZE; n -= 4 * WSIZE, wdst += 4, wsrc += 4){
+        wdst[0] = wsrc[0]; wdst[1] = wsrc[1];
+        wdst[2] = wsrc[2]; wdst[3] = wsrc[3];
+      }
+      for(; n >= WSIZE; n -= WSIZE)
+        *wdst++ = *wsrc++;
+      dst = (char*)wdst;
+      src = (const char*)wsrc;
+    }
     while(n-- > 0)
       *dst++ = *src++;
   } else {
     dst += n;
     src += n;
+    if(aligned){
+      for(; n > 0 && ((uint64)dst & WMASK) != 0; n--)
+        *--dst = *--src;
+      wdst = (uint64*)dst;
+      wsrc = (const uint64*)src;
+      for(; n >= WSIZE; n -= WSIZE)
+        *--wdst = *--wsrc;
+      dst = (char*)wdst;
+      src = (const char*)wsrc;
+    }
     while(n-- > 0)
       *--dst = *--src;
   }
@@ -134,7 +212,16 @@ memmove(void *vdst, const void *vsrc, int n)
 int
 memcmp(const void *s1, const void *s2, uint n)
 {
-  const char *p1 = s1, *p2 = s2;
+  const uchar *p1 = s1, *p2 = s2;
+
+  if(((uint64)p1 & WMASK) == ((uint64)p2 & WMASK)){
+    for(; n > 0 && ((uint64)p1 & WMASK) != 0; n--, p1++, p2++)
+      if (*p1 != *p2)
+        return *p1 - *p2;
+    // skip the equal words; the byte loop finds the difference.
+    for(; n >= WSIZE && *(uint64*)p1 == *(uint64*)p2; n -= WSIZE)
+      p1 += WSIZE, p2 += WSIZE;
+  }
   while (n-- > 0) {
     if (*p1 != *p2) {
       return *p1 - *p2;
@@ -150,3 +237,80 @@ memcpy(void *dst, const void *src, uint n)
 {
   return memmove(dst, src, n);
 }
+
+void
+mutex_init(struct mutex *m)
+{
+  m->state = 0;
+}
+
+int
+mutex_trylock(struct mutex *m)
+{
+  return __sync_val_compare_and_swap(&m->state, 0, 1) == 0;
+}
+
+void
+mutex_lock(struct mutex *m)
+{
+  int c;
+
+  // Uncontended: 0 -> 1 without entering the kernel.
+  if((c = __sync_val_compare_and_swap(&m->state, 0, 1)) == 0)
+    return;
+  // Holder is probably running on the other hart; give it a moment.
+  for(int i = 0; i < 100 && c != 0; i++)
+    if((c = __sync_val_compare_and_swap(&m->state, 0, 1)) == 0)
+      return;
+  // Mark the lock waited-on so that unlock wakes us, then sleep.
+  if(c != 2)
+    c = __sync_lock_test_and_set(&m->state, 2);
+  while(c != 0){
+    futex(&m->state, FUTEX_WAIT, 2);
+    c = __sync_lock_test_and_set(&m->state, 2);
+  }
+}
+
+void
+mutex_unlock(struct mutex *m)
+{
+  // Only enter the kernel if someone may be waiting.
+  if(__sync_fetch_and_sub(&m->state, 1) != 1){
+    __sync_lock_release(&m->state);
+    futex(&m->state, FUTEX_WAKE, 1);
+  }
+}
+
+void
+cond_init(struct cond *c)
+{
+  c->seq = 0;
+}
+
+// Atomically unlock m and wait for c to be signalled,
+// then relock m. May return spuriously.
+void
+cond_wait(struct cond *c, struct mutex *m)
+{
+  int seq = c->seq;
+
+  mutex_unlock(m);
+  futex(&c->seq, FUTEX_WAIT, seq);
+  // Others may be waiting on m too; take it as contended.
+  while(__sync_lock_test_and_set(&m->state, 2) != 0)
+    futex(&m->state, FUTEX_WAIT, 2);
+}
+
+void
+cond_signal(struct cond *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex(&c->seq, FUTEX_WAKE, 1);
+}
+
+void
+cond_broadcast(struct cond *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex(&c->seq, FUTEX_WAKE, 0x7fffffff);
+}
@@ -3,7 +3,10 @@
 #include "xv6-user/user.h"
 #include "kernel/include/param.h"
 
-// Memory allocator by Kernighan and Ritchie,
+// Small requests (up to SMALLMAX bytes) come from per-size-class
+// free lists, refilled a chunk at a time from sbrk(), so malloc
+// and free of small objects are O(1). Larger requests use the
+// memory allocator by Kernighan and Ritchie,
 // The C programming Language, 2nd ed.  Section 8.7.
 
 typedef long Align;
@@ -21,12 +24,39 @@ typedef union header Header;
 static Header base;
 static Header *freep;
 
+// Size classes hold 16 << c bytes, c = 0 .. NCLASS-1. A small
+// block's header records its class in s.size; a large block's
+// s.size is its length in units, always at least NCLASS.
+#define NCLASS    8
+#define SMALLMAX  (16 << (NCLASS - 1))
+#define CHUNK     8192        // bytes taken from sbrk() per refill
+
+static Header *bins[NCLASS];
+
+static void kr_free(Header *bp);
+
 void
 free(void *ap)
 {
-  Header *bp, *p;
+  Header *bp;
+  uint c;
 
+  if(ap == 0)
+    return;
   bp = (Header*)ap - 1;
+  if((c = bp->s.size) < NCLASS){
+    bp->s.ptr = bins[c];
+    bins[c] = bp;
+    return;
+  }
+  kr_free(bp);
+}
+
+static void
+kr_free(Header *bp)
+{
+  Header *p;
+
   for(p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
     if(p >= p->s.ptr && (bp > p || bp < p->s.ptr))
       break;
@@ -56,15 +86,46 @@ morecore(uint nu)
     return 0;
   hp = (Header*)p;
   hp->s.size = nu;
-  free((void*)(hp + 1));
+  kr_free(hp);
   return freep;
 }
 
+// Carve a fresh chunk into blocks of class c.
+static int
+refill(uint c)
+{
+  uint bsize = sizeof(Header) + (16 << c);
+  uint n = CHUNK / bsize;
+  char *p;
+  Header *hp;
+
+  if((p = sbrk(n * bsize)) == (char*)-1)
+    return -1;
+  for(; n > 0; n--, p += bsize){
+    hp = (Header*)p;
+    hp->s.size = c;
+    hp->s.ptr = bins[c];
+    bins[c] = hp;
+  }
+  return 0;
+}
+
 void*
 malloc(uint nbytes)
 {
   Header *p, *prevp;
-  uint nunits;
+  uint nunits, c;
+
+  if(nbytes <= SMALLMAX){
+    for(c = 0; (16 << c) < nbytes; c++)
+      ;
+    if(bins[c] == 0 && refill(c) < 0)
+      return 0;
+    p = bins[c];
+    bins[c] = p->s.ptr;
+    return (void*)(p + 1);
+  }
+
 
   nunits = (nbytes + sizeof(Header) - 1)/sizeof(Header) + 1;
   if((prevp = freep) == 0){
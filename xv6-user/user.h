@@ -1,10 +1,16 @@
 #include "kernel/include/types.h"
 #include "kernel/include/stat.h"
 #include "kernel/include/fcntl.h"
+#include "kernel/include/futex.h"
 
 struct stat;
 struct rtcdate;
 struct sysinfo;
+struct lockstat;
+struct cpustat;
+struct tracerec;
+struct profsample;
+struct lathist;
 
 // system calls
 int fork(void);
@@ -30,9 +36,74 @@ int dev(int, short, short);
 int readdir(int fd, struct stat*);
 int getcwd(char *buf);
 int remove(char *filename);
-int trace(int mask);
+int trace(uint64 mask);
 int sysinfo(struct sysinfo *);
 int rename(char *old, char *new);
+int nanosleep(uint64 nsec);
+int setpriority(int pid, int nice);
+int setscheduler(int pid, int policy);
+int sched_setaffinity(int pid, uint64 mask);
+uint64 sched_getaffinity(int pid);
+int clone(void (*fn)(void *), void *arg, void *stack);
+int futex(int *addr, int op, int val);
+int fcntl(int fd, int cmd, int arg);
+int splice(int fdin, int fdout, int n);
+int tee(int fdin, int fdout, int n);
+int lockstat(struct lockstat*, int n);
+int cpustat(int cpu, struct cpustat*);
+int traceread(int cpu, uint64 from, struct tracerec*, int n);
+int prof(int op, struct profsample*, int n);
+int latency(int op, int id, struct lathist*);
+int lseek(int fd, int off, int whence);
+uint64 rdtime(void);
+int sched_yield(void);
+
+// usys.S: raw stubs behind fork(), exec() and exit() in stdio.c
+int _fork(void);
+int _exec(char*, char**);
+int _exit(int) __attribute__((noreturn));
+
+// stdio.c
+#define BUFSIZ    1024
+#define EOF       (-1)
+
+#define _IONBF    0       // unbuffered: one write() per call
+#define _IOLBF    1       // line-buffered
+#define _IOFBF    2       // fully buffered
+#define _IOAUTO   3       // stdout: line-buffered if a device
+
+#define F_READ    0x1
+#define F_WRITE   0x2
+#define F_EOF     0x4
+#define F_ERR     0x8
+#define F_OWNBUF  0x10    // buf came from malloc()
+
+typedef struct iobuf {
+  int fd;
+  int flags;
+  int mode;
+  char *buf;
+  uint size;
+  uint pos;         // next byte to read, or bytes waiting to be written
+  uint len;         // bytes in buf, when reading
+  struct iobuf *next;
+} FILE;
+
+extern FILE *stdin, *stdout, *stderr;
+
+FILE* fopen(const char*, const char*);
+FILE* fdopen(int, const char*);
+int fclose(FILE*);
+int fflush(FILE*);
+int fputc(int, FILE*);
+int fputs(const char*, FILE*);
+uint fwrite(const void*, uint, uint, FILE*);
+int fgetc(FILE*);
+char* fgets(char*, int, FILE*);
+uint fread(void*, uint, uint, FILE*);
+int feof(FILE*);
+int ferror(FILE*);
+int setvbuf(FILE*, char*, int, uint);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -41,7 +112,7 @@ char* strcat(char*, const char*);
 void *memmove(void*, const void*, int);
 char* strchr(const char*, char c);
 int strcmp(const char*, const char*);
-void fprintf(int, const char*, ...);
+void fprintf(FILE*, const char*, ...);
 void printf(const char*, ...);
 char* gets(char*, int max);
 uint strlen(const char*);
@@ -51,3 +122,19 @@ void free(void*);
 int atoi(const char*);
 int memcmp(const void *, const void *, uint);
 void *memcpy(void *, const void *, uint);
+
+// ulib.c: locks for threads made with clone(), built on futex()
+struct mutex {
+  int state;      // 0 free, 1 held, 2 held and maybe waited on
+};
+struct cond {
+  int seq;        // bumped by every signal
+};
+void mutex_init(struct mutex*);
+void mutex_lock(struct mutex*);
+int mutex_trylock(struct mutex*);
+void mutex_unlock(struct mutex*);
+void cond_init(struct cond*);
+void cond_wait(struct cond*, struct mutex*);
+void cond_signal(struct cond*);
+void cond_broadcast(struct cond*);
@@ -2535,6 +2535,388 @@ execout(char *s)
   exit(0);
 }
 
+static volatile int clonevar;
+static int clonefd;
+static char clonestack[2][4096];
+
+static void
+clonechild(void *arg)
+{
+  clonevar = (int)(uint64)arg;
+  clonefd = dup(1);
+  exit(0);
+}
+
+static void
+clonespin(void *arg)
+{
+  for(;;)
+    clonevar++;
+}
+
+// a thread made by clone() shares memory and open files with
+// its creator, and doesn't outlive it.
+void
+clonetest(char *s)
+{
+  int tid, pid, xstatus;
+
+  clonevar = 0;
+  clonefd = -1;
+  tid = clone(clonechild, (void*)42, clonestack[0] + 4096);
+  if(tid < 0){
+    printf("%s: clone failed\n", s);
+    exit(1);
+  }
+  if(wait(0) != tid){
+    printf("%s: wait wrong tid\n", s);
+    exit(1);
+  }
+  if(clonevar != 42){
+    printf("%s: thread write not seen\n", s);
+    exit(1);
+  }
+  if(clonefd < 0 || close(clonefd) != 0){
+    printf("%s: thread fd not shared\n", s);
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    if(clone(clonespin, 0, clonestack[1] + 4096) < 0)
+      exit(1);
+    while(clonevar < 1000)
+      ;
+    exit(0);
+  }
+  wait(&xstatus);
+  exit(xstatus);
+}
+
+static struct mutex mutexm;
+static struct cond mutexc;
+static int mutexcount, mutexdone;
+
+static void
+mutexchild(void *arg)
+{
+  for(int i = 0; i < 10000; i++){
+    mutex_lock(&mutexm);
+    mutexcount++;
+    mutex_unlock(&mutexm);
+  }
+  mutex_lock(&mutexm);
+  mutexdone++;
+  cond_signal(&mutexc);
+  mutex_unlock(&mutexm);
+  exit(0);
+}
+
+// threads that take a futex-based mutex don't lose updates,
+// and a condition variable wakes up its waiter.
+void
+mutextest(char *s)
+{
+  mutex_init(&mutexm);
+  cond_init(&mutexc);
+  mutexcount = mutexdone = 0;
+  for(int i = 0; i < 2; i++){
+    if(clone(mutexchild, 0, clonestack[i] + 4096) < 0){
+      printf("%s: clone failed\n", s);
+      exit(1);
+    }
+  }
+  mutex_lock(&mutexm);
+  while(mutexdone < 2)
+    cond_wait(&mutexc, &mutexm);
+  mutex_unlock(&mutexm);
+  wait(0);
+  wait(0);
+  if(mutexcount != 20000){
+    printf("%s: count %d, expected 20000\n", s, mutexcount);
+    exit(1);
+  }
+  exit(0);
+}
+
+// lseek() within a file, and refusing to go outside it.
+void
+lseektest(char *s)
+{
+  int fd;
+  char c;
+
+  remove("lseekfile");
+  fd = open("lseekfile", O_CREATE|O_RDWR);
+  if(fd < 0){
+    printf("%s: create failed\n", s);
+    exit(1);
+  }
+  if(write(fd, "abcdefgh", 8) != 8){
+    printf("%s: write failed\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 2, SEEK_SET) != 2 || read(fd, &c, 1) != 1 || c != 'c'){
+    printf("%s: SEEK_SET\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 2, SEEK_CUR) != 5 || read(fd, &c, 1) != 1 || c != 'f'){
+    printf("%s: SEEK_CUR\n", s);
+    exit(1);
+  }
+  if(lseek(fd, -1, SEEK_END) != 7 || read(fd, &c, 1) != 1 || c != 'h'){
+    printf("%s: SEEK_END\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 0, SEEK_SET) != 0 || write(fd, "X", 1) != 1
+     || lseek(fd, 0, SEEK_SET) != 0 || read(fd, &c, 1) != 1 || c != 'X'){
+    printf("%s: overwrite\n", s);
+    exit(1);
+  }
+  if(lseek(fd, 9, SEEK_SET) != -1 || lseek(fd, -1, SEEK_SET) != -1
+     || lseek(fd, 0, 3) != -1){
+    printf("%s: seek out of range succeeded\n", s);
+    exit(1);
+  }
+  close(fd);
+  remove("lseekfile");
+}
+
+// write n bytes of a running pattern to fd.
+static void
+pipeput(char *s, int fd, int n, int *seq)
+{
+  char b[512];
+  int m;
+
+  for(; n > 0; n -= m){
+    m = n < sizeof(b) ? n : sizeof(b);
+    for(int i = 0; i < m; i++)
+      b[i] = (*seq)++ % 251;
+    if(write(fd, b, m) != m){
+      printf("%s: write failed\n", s);
+      exit(1);
+    }
+  }
+}
+
+// read n bytes from fd and check they carry on the pattern.
+static void
+pipeget(char *s, int fd, int n, int *seq)
+{
+  char b[512];
+  int m;
+
+  for(; n > 0; n -= m){
+    m = read(fd, b, n < sizeof(b) ? n : sizeof(b));
+    if(m <= 0){
+      printf("%s: read failed\n", s);
+      exit(1);
+    }
+    for(int i = 0; i < m; i++){
+      if((uchar)b[i] != (*seq)++ % 251){
+        printf("%s: wrong byte\n", s);
+        exit(1);
+      }
+    }
+  }
+}
+
+// growing and shrinking a pipe with F_SETPIPE_SZ keeps the
+// data it holds, even when that wraps around the ring.
+void
+pipesizetest(char *s)
+{
+  int fds[2], sz, big, len, w = 0, r = 0;
+
+  if(pipe(fds) != 0){
+    printf("%s: pipe() failed\n", s);
+    exit(1);
+  }
+  sz = fcntl(fds[0], F_GETPIPE_SZ, 0);
+  if(sz <= 0){
+    printf("%s: F_GETPIPE_SZ failed\n", s);
+    exit(1);
+  }
+
+  // leave sz-10 bytes that wrap around the end of the ring.
+  pipeput(s, fds[1], sz - 10, &w);
+  pipeget(s, fds[0], sz / 2, &r);
+  pipeput(s, fds[1], sz / 2, &w);
+  len = sz - 10;
+
+  big = fcntl(fds[1], F_SETPIPE_SZ, sz + 8192);
+  if(big < sz + 8192 || fcntl(fds[0], F_GETPIPE_SZ, 0) != big){
+    printf("%s: grow failed\n", s);
+    exit(1);
+  }
+  // fill past the old size, and wrap around the new one.
+  pipeput(s, fds[1], 6000, &w);
+  len += 6000;
+  for(int i = 0; i < 5; i++){
+    pipeget(s, fds[0], 3000, &r);
+    pipeput(s, fds[1], 3000, &w);
+  }
+
+  if(fcntl(fds[0], F_SETPIPE_SZ, 0) != -1 || fcntl(fds[0], F_GETPIPE_SZ, 0) != big){
+    printf("%s: shrink below the buffered data succeeded\n", s);
+    exit(1);
+  }
+  pipeget(s, fds[0], len - sz / 2, &r);
+  len = sz / 2;
+  if(fcntl(fds[0], F_SETPIPE_SZ, 0) != sz){
+    printf("%s: shrink failed\n", s);
+    exit(1);
+  }
+  pipeget(s, fds[0], len, &r);
+  pipeput(s, fds[1], sz, &w);
+  pipeget(s, fds[0], sz, &r);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// splice() between a file and a pipe, and between two pipes.
+void
+splicetest(char *s)
+{
+  int fd, a[2], b[2], w = 0, r = 0;
+
+  remove("splicefile");
+  fd = open("splicefile", O_CREATE|O_RDWR);
+  if(fd < 0){
+    printf("%s: create failed\n", s);
+    exit(1);
+  }
+  pipeput(s, fd, 5000, &w);
+  if(pipe(a) != 0 || pipe(b) != 0){
+    printf("%s: pipe() failed\n", s);
+    exit(1);
+  }
+
+  // file -> pipe, up to the end of the file.
+  lseek(fd, 0, SEEK_SET);
+  if(splice(fd, a[1], 3000) != 3000){
+    printf("%s: file to pipe\n", s);
+    exit(1);
+  }
+  pipeget(s, a[0], 3000, &r);
+  if(splice(fd, a[1], 5000) != 2000 || splice(fd, a[1], 5000) != 0){
+    printf("%s: file to pipe at end of file\n", s);
+    exit(1);
+  }
+  pipeget(s, a[0], 2000, &r);
+
+  // pipe -> file
+  w = r = 0;
+  pipeput(s, a[1], 3000, &w);
+  lseek(fd, 0, SEEK_SET);
+  if(splice(a[0], fd, 3000) != 3000){
+    printf("%s: pipe to file\n", s);
+    exit(1);
+  }
+  lseek(fd, 0, SEEK_SET);
+  pipeget(s, fd, 3000, &r);
+
+  // pipe -> pipe
+  w = r = 0;
+  pipeput(s, a[1], 2000, &w);
+  if(splice(a[0], b[1], 2000) != 2000){
+    printf("%s: pipe to pipe\n", s);
+    exit(1);
+  }
+  pipeget(s, b[0], 2000, &r);
+
+  if(splice(a[0], a[1], 1) != -1){
+    printf("%s: splice into the same pipe succeeded\n", s);
+    exit(1);
+  }
+  close(fd);
+  if((fd = open(".", O_RDONLY)) < 0 || splice(fd, a[1], 1) != -1){
+    printf("%s: splice from a directory succeeded\n", s);
+    exit(1);
+  }
+  close(fd);
+  close(a[1]);
+  if(read(a[0], buf, 1) != 0){
+    printf("%s: data left in the source pipe\n", s);
+    exit(1);
+  }
+  close(a[0]);
+  close(b[0]);
+  close(b[1]);
+  remove("splicefile");
+}
+
+// tee() copies a pipe's data without consuming it.
+void
+teetest(char *s)
+{
+  int a[2], b[2], w = 0, r = 0;
+
+  if(pipe(a) != 0 || pipe(b) != 0){
+    printf("%s: pipe() failed\n", s);
+    exit(1);
+  }
+  pipeput(s, a[1], 1000, &w);
+  if(tee(a[0], b[1], 1000) != 1000){
+    printf("%s: tee failed\n", s);
+    exit(1);
+  }
+  pipeget(s, b[0], 1000, &r);
+  r = 0;
+  pipeget(s, a[0], 1000, &r);
+  if(tee(a[0], a[1], 1) != -1){
+    printf("%s: tee into the same pipe succeeded\n", s);
+    exit(1);
+  }
+  close(a[0]);
+  close(a[1]);
+  close(b[0]);
+  close(b[1]);
+}
+
+// two processes splice from one pipe into a full one whose
+// reader then goes away: both get -1, and the data they were
+// moving stays in the source pipe.
+void
+splicerace(char *s)
+{
+  int a[2], b[2], pid, xstatus, w = 0, r = 0, junk = 0;
+
+  if(pipe(a) != 0 || pipe(b) != 0){
+    printf("%s: pipe() failed\n", s);
+    exit(1);
+  }
+  pipeput(s, a[1], 100, &w);
+  pipeput(s, b[1], fcntl(b[1], F_GETPIPE_SZ, 0), &junk);
+  for(int i = 0; i < 2; i++){
+    pid = fork();
+    if(pid < 0){
+      printf("%s: fork failed\n", s);
+      exit(1);
+    }
+    if(pid == 0){
+      close(b[0]);
+      exit(splice(a[0], b[1], 100) == -1 ? 0 : 1);
+    }
+  }
+  sleep(5);
+  close(b[0]);
+  for(int i = 0; i < 2; i++){
+    wait(&xstatus);
+    if(xstatus != 0){
+      printf("%s: splice into a pipe without a reader succeeded\n", s);
+      exit(1);
+    }
+  }
+  pipeget(s, a[0], 100, &r);
+  exit(0);
+}
+
 //
 // use sbrk() to count how many free physical memory pages there are.
 // touches the pages to force allocation.
@@ -2648,6 +3030,13 @@ main(int argc, char *argv[])
     char *s;
   } tests[] = {
     {execout, "execout"},
+    {clonetest, "clonetest"},
+    {mutextest, "mutextest"},
+    {lseektest, "lseektest"},
+    {pipesizetest, "pipesizetest"},
+    {splicetest, "splicetest"},
+    {teetest, "teetest"},
+    {splicerace, "splicerace"},
     {copyin, "copyin"},
     {copyout, "copyout"},
     {copyinstr1, "copyinstr1"},
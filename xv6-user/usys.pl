@@ -6,24 +6,27 @@ print "# generated by usys.pl - do not edit\n";
 
 print "#include \"kernel/include/sysnum.h\"\n";
 
+# entry(name[, label]): label defaults to name. fork, exec and
+# exit are wrapped in stdio.c, which flushes streams first.
 sub entry {
     my $name = shift;
-    print ".global $name\n";
-    print "${name}:\n";
+    my $label = shift // $name;
+    print ".global $label\n";
+    print "${label}:\n";
     print " li a7, SYS_${name}\n";
     print " ecall\n";
     print " ret\n";
 }
 	
-entry("fork");
-entry("exit");
+entry("fork", "_fork");
+entry("exit", "_exit");
 entry("wait");
 entry("pipe");
 entry("read");
 entry("write");
 entry("close");
 entry("kill");
-entry("exec");
+entry("exec", "_exec");
 entry("open");
 entry("fstat");
 entry("mkdir");
@@ -41,3 +44,21 @@ entry("remove");
 entry("trace");
 entry("sysinfo");
 entry("rename");
+entry("nanosleep");
+entry("setpriority");
+entry("setscheduler");
+entry("sched_setaffinity");
+entry("sched_getaffinity");
+entry("clone");
+entry("futex");
+entry("fcntl");
+entry("splice");
+entry("tee");
+entry("lockstat");
+entry("cpustat");
+entry("traceread");
+entry("prof");
+entry("latency");
+entry("lseek");
+entry("rdtime");
+entry("sched_yield");
@@ -0,0 +1,132 @@
+#include "kernel/include/types.h"
+#include "kernel/include/param.h"
+#include "kernel/include/sysinfo.h"
+#include "kernel/include/cpustat.h"
+#include "xv6-user/user.h"
+
+// vmstat [-s] [-c CPU] [SECONDS [COUNT]]
+// print system event rates: one line of totals since boot, then
+// one line per SECONDS of the events in that interval, COUNT
+// times (forever if omitted). -c looks at one hart only; -s
+// prints every counter since boot, by syscall and IRQ as well.
+
+#define HZ  (CLK_FREQ / INTERVAL)   // sleep() ticks per second
+
+static struct cpustat cur, prev;
+
+static void
+header(void)
+{
+  printf("   free procs     cs    sys    pf   intr  timer  dread dwrite   bhit  bmiss   ehit  emiss\n");
+}
+
+static void
+col(uint64 v, int width)
+{
+  char buf[24];
+  int n = 0;
+
+  do
+    buf[n++] = '0' + v % 10;
+  while((v /= 10) != 0);
+  for(int i = n; i < width; i++)
+    fputc(' ', stdout);
+  while(n > 0)
+    fputc(buf[--n], stdout);
+}
+
+static void
+line(struct cpustat *a, struct cpustat *b)
+{
+  struct sysinfo info;
+
+  sysinfo(&info);
+  col(info.freemem >> 10, 6);
+  fputc('K', stdout);
+  col(info.nproc, 6);
+  col(a->ctxsw - b->ctxsw, 7);
+  col(a->syscall - b->syscall, 7);
+  col(a->pgfault - b->pgfault, 6);
+  col(a->intr - b->intr, 7);
+  col(a->timer - b->timer, 7);
+  col(a->diskread - b->diskread, 7);
+  col(a->diskwrite - b->diskwrite, 7);
+  col(a->bhit - b->bhit, 7);
+  col(a->bmiss - b->bmiss, 7);
+  col(a->ehit - b->ehit, 7);
+  col(a->emiss - b->emiss, 7);
+  fputc('\n', stdout);
+  fflush(stdout);
+}
+
+static void
+summary(int cpu)
+{
+  int i;
+
+  if(cpu >= 0)
+    printf("hart %d\n", cpu);
+  printf("context switches\t%l\n", cur.ctxsw);
+  printf("system calls\t\t%l\n", cur.syscall);
+  printf("user page faults\t%l\n", cur.pgfault);
+  printf("device interrupts\t%l\n", cur.intr);
+  printf("timer interrupts\t%l\n", cur.timer);
+  printf("disk sectors read\t%l\n", cur.diskread);
+  printf("disk sectors written\t%l\n", cur.diskwrite);
+  printf("buffer cache hits\t%l\n", cur.bhit);
+  printf("buffer cache misses\t%l\n", cur.bmiss);
+  printf("entry cache hits\t%l\n", cur.ehit);
+  printf("entry cache misses\t%l\n", cur.emiss);
+  for(i = 0; i < CPUSTAT_NSYSCALL; i++)
+    if(cur.nsyscall[i])
+      printf("syscall %d\t\t%l\n", i, cur.nsyscall[i]);
+  for(i = 0; i < CPUSTAT_NIRQ; i++)
+    if(cur.nirq[i])
+      printf("irq %d\t\t\t%l\n", i, cur.nirq[i]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, cpu = -1, all = 0, secs = 0, count = -1;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++){
+    if(strcmp(argv[i], "-s") == 0)
+      all = 1;
+    else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+      cpu = atoi(argv[++i]);
+    else
+      goto usage;
+  }
+  if(i < argc)
+    secs = atoi(argv[i++]);
+  if(i < argc)
+    count = atoi(argv[i++]);
+  if(i < argc || secs < 0)
+    goto usage;
+
+  if(cpustat(cpu, &cur) < 0){
+    fprintf(stderr, "vmstat: no hart %d\n", cpu);
+    exit(1);
+  }
+  if(all){
+    summary(cpu);
+    exit(0);
+  }
+
+  header();
+  line(&cur, &prev);
+  for(i = 1; secs > 0 && (count < 0 || i < count); i++){
+    prev = cur;
+    sleep(secs * HZ);
+    cpustat(cpu, &cur);
+    if(i % 20 == 0)
+      header();
+    line(&cur, &prev);
+  }
+  exit(0);
+
+usage:
+  fprintf(stderr, "usage: vmstat [-s] [-c CPU] [SECONDS [COUNT]]\n");
+  exit(1);
+}
@@ -6,29 +6,27 @@
  * len:    include the 0 in the end.
  * return: the number of bytes that read successfully (0 in the end is not included)
  */
-int readline(int fd, char *buf, int len)
+int readline(FILE *f, char *buf, int len)
 {
     char *p = buf;
-    while (read(fd, p, 1) != 0 && p < buf + len) {
-        if (*p == '\n') {
+    int c;
+    while ((c = fgetc(f)) != EOF && p < buf + len - 1) {
+        if (c == '\n') {
             if (p == buf) {     // ignore empty line
                 continue;
             }
-            *p = '\0';
             break;
         }
-        p++;
-    }
-    if (p == buf) {
-        return 0;
+        *p++ = c;
     }
+    *p = '\0';
     return p - buf;
 }
 
 int main(int argc, char *argv[])
 {
     if (argc < 2) {
-        fprintf(2, "Usage: xargs COMMAND [INITIAL-ARGS]...\n");
+        fprintf(stderr, "Usage: xargs COMMAND [INITIAL-ARGS]...\n");
         exit(-1);
     }
     char *argvs[MAXARG];
@@ -38,7 +36,7 @@ int main(int argc, char *argv[])
         argvs[i - 1] = argv[i];         // argvs[0] = COMMAND
     }
     i--;
-    if (readline(0, buf, 128) == 0) {   // if there is no input
+    if (readline(stdin, buf, 128) == 0) {   // if there is no input
         argvs[i] = 0;
         if (fork() == 0) {
             exec(argv[1], argvs);
@@ -56,7 +54,7 @@ int main(int argc, char *argv[])
                 exit(0);
             }
             wait(0);
-        } while (readline(0, buf, 128) != 0);
+        } while (readline(stdin, buf, 128) != 0);
     }
     exit(0);
 }